@@ -16,229 +16,467 @@
 /// Application for self-study
 ///
 
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <climits>
 #include "VocaMaster.h"
+#include "strutil.h"
+#include "importer.h"
+#include "deckfile.h"
+#include "merge.h"
+#include "server.h"
+#include "loadgen.h"
+#include "manager.h"
+#include "wordhash.h"
+#include "probe.h"
 
 #define FILENAME      "voca.dat"
 #define VERSION       1.2
 #define TRACE_SAVE    0
+#define DAY_SECONDS   86400
+#define SIM_SUFFIX    ".sim"
+#define DICT_SUFFIX   ".dict"
+#define LOG_SUFFIX    ".log"
+#define PAGE_SIZE     10
+#define FIELD_SIZE    DeckReader::FIELD_SIZE
+#define SIM_THRESHOLD 20 ///< similarity threshold value as percent
+#define CACHE_MB      64 ///< default memory budget of cached decks
+#define SCAN_PARALLEL 4096 ///< deck size from which similarity scan is split
+#define SCAN_CHUNK    256  ///< words per chunk of split similarity scan
+#define QUERY_CACHE   64   ///< search results kept in query cache
+#define DICT_LOOKUPS  8    ///< unchanged word lookups before dictionary is built
+#define DICT_TAIL     256  ///< words added past dictionary before it is rebuilt
 
 using namespace std;
 
+#ifndef NO_MAIN // benchmark links engine with its own main
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
-/// @brief Self-implemented multi-handy inline functions
-/// @details In this program, there are many functions handling string @n
-///          but for not using string header library, most string handling @n
-///          functions are created based on how it works basically.
+/// @brief main function
 ///
 
-static inline bool isWhite(char c) {
-  return (c == '\n' || c == '\t' || c == ' ');
-}
-
-static inline int Strlen(char* str) {
-  if (str == NULL) {
-    cout << "STRING LENGTH NULL ERROR" << endl;
-    exit(1);
-  }
-  
-  int i;
-  for (i = 0; str[i] != '\0'; i++) {}
-  
-  return i;
+static void usage(char* name) {
+  cout << "usage : " << name << " [--seed NUMBER] [--deck FILE]"
+       << " [--dir DIR] [--cache-mb NUMBER] [--mem-mb NUMBER]"
+       << " [--stats human|json] [--paged] [--shards NUMBER]" << endl;
+  cout << "        " << name << " [--deck FILE] search WORD... (- : words from stdin)" << endl;
+  cout << "        " << name << " [--deck FILE] add WORD MEANING EXPLAIN" << endl;
+  cout << "        " << name << " [--deck FILE] delete WORD... (- : words from stdin)" << endl;
+  cout << "        " << name << " [--deck FILE] list [--page NUMBER]" << endl;
+  cout << "        " << name << " [--deck FILE] stats" << endl;
+  cout << "        " << name << " [--deck FILE] history word|level|day" << endl;
+  cout << "        " << name << " [--deck FILE] import FILE (- : stdin)"
+       << " [--report FILE] [--threads NUMBER]" << endl;
+  cout << "        " << name << " merge DECK_A DECK_B OUTPUT"
+       << " [--policy max|latest|sum] [--report FILE]" << endl;
+  cout << "        " << name << " diff DECK_A DECK_B [--report FILE]" << endl;
+  cout << "        " << name << " [--deck FILE] serve SOCKET [--workers NUMBER]" << endl;
+  cout << "        " << name << " loadgen SOCKET"
+       << " [--clients NUMBER] [--requests NUMBER]" << endl;
 }
 
-static inline void Strcpy(char* dst, char* src) {
-  if (dst == NULL || src == NULL) {
-    cout << "STRING COPY NULL ERROR" << endl;
-    exit(1);
-  }
+static int statsMode = 0; ///< 0 : none, 1 : human, 2 : json
 
-  for (int i = 0; i < Strlen(src); i++)
-    dst[i] = src[i];
-  
-  dst[Strlen(src)] = '\0';
+/// @brief writing probe report at exit, to stderr beside command output
+static void printStats(void) {
+  if (statsMode)
+    Probe::report(&cerr, statsMode == 2);
 }
 
-static inline bool Strequal(char* str1, char* str2) {
-  if (str1 == NULL || str2 == NULL) {
-    cout << "STRING NULL ERROR" << endl;
-    exit(1);
-  }
-
-  if (Strlen(str1) != Strlen(str2))
-    return false;
-
-  for (int i = 0; i < Strlen(str1); i++) {
-    if (str1[i] != str2[i])
-      return false;
+int main(int argc, char** argv) {
+  bool seeded = false;
+  unsigned long long seed = 0;
+  char *deck = (char*)FILENAME;
+  char *dir = (char*)".";
+  unsigned long cacheMb = CACHE_MB;
+
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] == '-'; arg++) {
+    if (Strequal(argv[arg], (char*)"--seed") && arg + 1 < argc) {
+      seed = StrToInt(argv[++arg]);
+      seeded = true;
+    } else if (Strequal(argv[arg], (char*)"--deck") && arg + 1 < argc) {
+      deck = argv[++arg];
+    } else if (Strequal(argv[arg], (char*)"--dir") && arg + 1 < argc) {
+      dir = argv[++arg];
+    } else if (Strequal(argv[arg], (char*)"--cache-mb") && arg + 1 < argc) {
+      cacheMb = StrToInt(argv[++arg]);
+    } else if (Strequal(argv[arg], (char*)"--mem-mb") && arg + 1 < argc) {
+      VocaEngine::setBudget(StrToInt(argv[++arg]) * 1024 * 1024);
+    } else if (Strequal(argv[arg], (char*)"--paged")) {
+      VocaEngine::setPaged(true);
+    } else if (Strequal(argv[arg], (char*)"--shards") && arg + 1 < argc &&
+               StrToInt(argv[arg + 1]) >= 1 &&
+               StrToInt(argv[arg + 1]) <= DeckShards::MAX) {
+      VocaEngine::setShards(StrToInt(argv[++arg]));
+    } else if (Strequal(argv[arg], (char*)"--stats") && arg + 1 < argc &&
+               (Strequal(argv[arg + 1], (char*)"human") ||
+                Strequal(argv[arg + 1], (char*)"json"))) {
+      statsMode = Strequal(argv[++arg], (char*)"json") ? 2 : 1;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
   }
+  atexit(printStats);
+
+  if (arg < argc) { // batch command
+    char *cmd = argv[arg++];
+    int ret = 0;
+
+    if (Strequal(cmd, (char*)"search") && arg < argc) {
+      VocaEngine engine(deck, true);
+      if (Strequal(argv[arg], (char*)"-")) {
+        char buf[100];
+        cin.width(sizeof(buf));
+        while (cin >> buf) {
+          engine.cmdSearch(buf, &cout);
+          cin.width(sizeof(buf));
+        }
+      } else {
+        for (; arg < argc; arg++)
+          engine.cmdSearch(argv[arg], &cout);
+      }
+    } else if (Strequal(cmd, (char*)"add") && arg + 3 == argc) {
+      VocaEngine engine(deck, true);
+      if (!engine.cmdAdd(argv[arg], argv[arg + 1], argv[arg + 2], &cout))
+        ret = 2;
+    } else if (Strequal(cmd, (char*)"delete") && arg < argc) {
+      VocaEngine engine(deck, true);
+      Array <char*> words;
+      bool piped = Strequal(argv[arg], (char*)"-");
+      if (piped) {
+        char buf[100];
+        cin.width(sizeof(buf));
+        while (cin >> buf) {
+          char *word = new char[sizeof(char) * Strlen(buf) + 1];
+          Strcpy(word, buf);
+          words.add(word);
+          cin.width(sizeof(buf));
+        }
+      } else {
+        for (; arg < argc; arg++)
+          words.add(argv[arg]);
+      }
 
-  return true;
-}
+      char **list = new char*[words.getSize() + 1];
+      for (unsigned int k = 0; k < words.getSize(); k++)
+        list[k] = words.get(k);
+      if (engine.cmdDelete(list, words.getSize(), &cout) == 0)
+        ret = 2;
+      delete[] list;
+      for (unsigned int k = 0; piped && k < words.getSize(); k++)
+        delete[] words.get(k);
+    } else if (Strequal(cmd, (char*)"list") && arg == argc) {
+      VocaEngine engine(deck, true);
+      if (!engine.cmdList(1, &cout))
+        ret = 2;
+    } else if (Strequal(cmd, (char*)"list") && arg + 2 == argc &&
+               Strequal(argv[arg], (char*)"--page")) {
+      VocaEngine engine(deck, true);
+      if (!engine.cmdList(StrToInt(argv[arg + 1]), &cout))
+        ret = 2;
+    } else if (Strequal(cmd, (char*)"stats") && arg == argc) {
+      VocaEngine engine(deck, true);
+      engine.cmdStats(&cout);
+      engine.cmdMemory(&cout);
+    } else if (Strequal(cmd, (char*)"history") && arg + 1 == argc &&
+               HistoryTally::parseGroup(argv[arg]) >= 0) {
+      // log is streamed, deck itself is not loaded
+      char *logFile = Strjoin(deck, (char*)LOG_SUFFIX);
+      ifstream in(logFile, ios::binary);
+      HistoryTally tally(HistoryTally::parseGroup(argv[arg]));
+      if (!in.good()) {
+        cout << "error\tcannot open\t" << logFile << endl;
+        ret = 2;
+      } else {
+        if (!tally.read(&in)) {
+          cout << "error\tbroken log\t" << logFile << endl;
+          ret = 2;
+        }
+        tally.report(&cout); // events before broken part are counted
+      }
+      delete[] logFile;
+    } else if (Strequal(cmd, (char*)"import") && arg < argc) {
+      char *source = argv[arg++];
+      char *reportFile = NULL;
+      int threads = 0;
+
+      for (; arg + 1 < argc; arg += 2) {
+        if (Strequal(argv[arg], (char*)"--report"))
+          reportFile = argv[arg + 1];
+        else if (Strequal(argv[arg], (char*)"--threads"))
+          threads = StrToInt(argv[arg + 1]);
+        else
+          break;
+      }
+      if (arg != argc) {
+        usage(argv[0]);
+        return 1;
+      }
 
-static inline int Strtype(char* str) { // 0 : null, 1 : ascii, 2: unicode
-  if (str) {
-    if ((int)str[0] >= 0) // including ascii NULL
-      return 1; // ascii
-    else
-      return 2; // unicode
-  }
+      istream *in = &cin;
+      if (!Strequal(source, (char*)"-"))
+        in = new ifstream(source);
+      ostream *report = &cout;
+      if (reportFile)
+        report = new ofstream(reportFile);
 
-  return 0; // null
-}
+      if (!in->good() || !report->good()) {
+        cout << "error\tcannot open\t" << (in->good() ? reportFile : source) << endl;
+        return 2;
+      }
 
-static inline int Strsim(char* str1, char* str2, int type) { // type [ 1: ascii, 2: unicode ]
-  char *larger = NULL; char *smaller = NULL;
-  
-  if (Strlen(str1) >= Strlen(str2)) {
-    larger = str1; smaller = str2;
-  } else {
-    larger = str2; smaller = str1;
-  }
-  
-  if (type == 1) { // ascii
-    for (int tmpSize = Strlen(smaller); tmpSize > (Strlen(smaller) / 2); tmpSize--) {
-      for (int tmpIndex = 0; tmpIndex <= (Strlen(smaller) - tmpSize); tmpIndex++) {
-        for (int cmpIndex = 0; cmpIndex <= (Strlen(larger) - tmpSize); cmpIndex++) {
-          bool equal = true;
-          for (int i = 0; i < tmpSize; i++) {
-            if (smaller[tmpIndex + i] != larger[cmpIndex + i]) {
-              equal = false;
-              break;
-            }
-          }
-
-          if (equal)
-            return 100 * tmpSize / Strlen(larger);
-        }
+      VocaEngine *engine = new VocaEngine(deck, true);
+      engine->cmdImport(in, report, threads);
+      delete(engine); // save once
+
+      if (in != &cin)
+        delete(in);
+      if (report != &cout)
+        delete(report);
+    } else if ((Strequal(cmd, (char*)"merge") && arg + 3 <= argc) ||
+               (Strequal(cmd, (char*)"diff") && arg + 2 <= argc)) {
+      bool merging = Strequal(cmd, (char*)"merge");
+      char *deckA = argv[arg++];
+      char *deckB = argv[arg++];
+      char *output = merging ? argv[arg++] : NULL;
+      char *reportFile = NULL;
+      int policy = DeckMerge::POLICY_MAX;
+
+      for (; arg + 1 < argc; arg += 2) {
+        if (Strequal(argv[arg], (char*)"--report"))
+          reportFile = argv[arg + 1];
+        else if (merging && Strequal(argv[arg], (char*)"--policy"))
+          policy = DeckMerge::parsePolicy(argv[arg + 1]);
+        else
+          break;
       }
-    }
-  }
-  else {
-    for (int tmpSize = Strlen(smaller); tmpSize > (Strlen(smaller) / 2); tmpSize -= 3) {
-      for (int tmpIndex = 0; tmpIndex <= (Strlen(smaller) - tmpSize); tmpIndex += 3) {
-        for (int cmpIndex = 0; cmpIndex <= (Strlen(larger) - tmpSize); cmpIndex += 3) {
-          bool equal = true;
-          for (int i = 0; i < tmpSize; i++) {
-            if (smaller[tmpIndex + i] != larger[cmpIndex + i]) {
-              equal = false;
-              break;
-            }
-          }
-
-          if (equal)
-            return 100 * tmpSize / Strlen(larger);
-        }
+      if (arg != argc || policy < 0) {
+        usage(argv[0]);
+        return 1;
       }
-    }
-  }
 
-  return 0; // no match
-}
+      DeckMerge *merger = new DeckMerge(policy);
+      if (!merger->load(deckA, deckB)) {
+        cout << "error	cannot read	" << deckA << " or " << deckB << endl;
+        delete(merger);
+        return 2;
+      }
 
-static inline int StrToInt(char* str) {
-  int ret = 0;
+      ostream *report = &cout;
+      if (reportFile)
+        report = new ofstream(reportFile);
+      ofstream *out = merging ? new ofstream(output) : NULL;
+
+      if (!report->good() || (out && !out->good())) {
+        cout << "error	cannot open	"
+             << (report->good() ? output : reportFile) << endl;
+        ret = 2;
+      } else if (merging) {
+        merger->merge(out, report);
+      } else {
+        merger->diff(report);
+      }
 
-  for (int i = 0; i < Strlen(str); i++)
-    ret = (ret * 10) + (int)(str[i] - '0');
+      if (ret == 0)
+        cout << (merging ? "merged" : "compared")
+             << "	only_a " << merger->getOnlyA()
+             << "	only_b " << merger->getOnlyB()
+             << "	same " << merger->getSame()
+             << "	" << (merging ? "conflict " : "changed ")
+             << merger->getConflict() << endl;
+
+      delete(merger);
+      if (out)
+        delete(out);
+      if (report != &cout)
+        delete(report);
+    } else if (Strequal(cmd, (char*)"serve") &&
+               (arg + 1 == argc || (arg + 3 == argc &&
+                Strequal(argv[arg + 1], (char*)"--workers")))) {
+      int workers = (arg + 3 == argc) ? (int)StrToInt(argv[arg + 2]) : 0;
+      VocaEngine::setPaged(false); // workers read text concurrently
+      VocaEngine *engine = new VocaEngine(deck, true);
+      if (seeded)
+        engine->setSeed(seed);
+
+      VocaServer *server = new VocaServer(engine, argv[arg], workers);
+      if (server->start())
+        server->run();
+      else
+        ret = 2;
+      delete(server);
+      delete(engine); // save once, after every request is done
+    } else if (Strequal(cmd, (char*)"loadgen") && arg < argc) {
+      char *socketPath = argv[arg++];
+      int clients = 8;
+      int requests = 1000;
+
+      for (; arg + 1 < argc; arg += 2) {
+        if (Strequal(argv[arg], (char*)"--clients"))
+          clients = StrToInt(argv[arg + 1]);
+        else if (Strequal(argv[arg], (char*)"--requests"))
+          requests = StrToInt(argv[arg + 1]);
+        else
+          break;
+      }
+      if (arg != argc) {
+        usage(argv[0]);
+        return 1;
+      }
 
-  return ret;
-}
+      LoadGenerator load(socketPath, clients, requests);
+      if (!load.run(&cout))
+        ret = 2;
+    } else {
+      usage(argv[0]);
+      ret = 1;
+    }
 
-static inline char* IntToStr(int num) {
-  int tmp = num;
-  int length = 0;
-  
-  if (num == 0) {
-    char *ret = new char[2];
-    ret[0] = '0'; ret[1] = '\0';
     return ret;
   }
 
-  while (tmp > 0) {
-    tmp /= 10;
-    length++;
-  }
-
-  char *buf = new char[sizeof(char) * length + 1];
-  
-  int index = length - 1;
-  for (tmp = num; tmp > 0; tmp /= 10)
-    buf[index--] = (char)(tmp % 10 + '0');
-  buf[length] = '\0';
-
-  return buf;
-}
+  // decks chosen in menu stay loaded within budget
+  VocaEngine::printTitle();
+  DeckManager *decks = new DeckManager(dir, cacheMb * 1024 * 1024);
+  VocaEngine *engine = decks->open(deck);
 
-////////////////////////////////////////////////////////////////////////////////
-///
-/// @brief main function
-///
+  if (seeded)
+    engine->setSeed(seed);
 
-int main(void) {
-  ifstream *iFile = new ifstream(FILENAME);
-  VocaEngine *engine = new VocaEngine(iFile);  
-  iFile->close();
+  cout << "#    DECK " << deck << " : " << engine->getSize() << " WORDS" << endl;
+  cout << "#" << endl;
   
   bool good = true;
   while (good) {
     engine->showMenu();
     good = engine->processMenu();
+
+    char *next = engine->takeSwitch();
+    if (next) {
+      engine = decks->open(next);
+      cout << "#    DECK " << next << " : " << engine->getSize() << " WORDS"
+           << " (" << decks->getCached() << " IN MEMORY)" << endl;
+      cout << "#" << endl;
+      delete[] next;
+      good = true;
+    }
   }
 
-  if (engine)
-    delete (engine);
+  delete(decks); // save every deck
+  VocaEngine::printEnd();
 
   return 0;
 }
 
+#endif  /* NO_MAIN */
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 /// @brief Voca class functions implementation
 ///
 
-Voca::Voca() : exp(0), level(1)
+Voca::Voca() : exp(0), level(1), due(0), interval(0), dead(false),
+  onDisk(false), tag(0)
 {
   word = NULL;
-  meaning = NULL;
-  explain = NULL;
+  text.resident.meaning = NULL;
+  text.resident.explain = NULL;
 }
 
-Voca::Voca(char* w, char* m, char* e, int x, int l) : exp(x), level(l)
+Voca::Voca(char* w, char* m, char* e, int x, int l, long d, int v)
+  : exp(x), level(l), due(d), interval(v), dead(false), onDisk(false), tag(0)
 {
-  word = new char[sizeof(char) * Strlen(w) + 1];
-  Strcpy(word, w);
+  word = StringPool::intern(w);
+  text.resident.explain = StringPool::intern(e);
+
+  int cut = findTag(m);
+  if (cut > 0)
+    tag = StringPool::toLabel(m + cut);
+  if (tag == 0) {
+    text.resident.meaning = StringPool::intern(m);
+    return;
+  }
+
+  char stem[MEAN_SIZE];
+  for (int k = 0; k < cut; k++)
+    stem[k] = m[k];
+  stem[cut] = '\0';
+  text.resident.meaning = StringPool::intern(stem);
+}
 
-  meaning = new char[sizeof(char) * Strlen(m) + 1];
-  Strcpy(meaning, m);
+Voca::Voca(char* w, DeckPager* p, unsigned long long o, int x, int l, long d,
+           int v)
+  : exp(x), level(l), due(d), interval(v), dead(false), onDisk(true), tag(0)
+{
+  word = StringPool::intern(w);
+  text.paged.pager = p;
+  text.paged.offset = o;
+}
 
-  explain = new char[sizeof(char) * Strlen(e) + 1];
-  Strcpy(explain, e);
+Voca::Voca(const Voca& v)
+  : exp(v.exp), level(v.level), due(v.due), interval(v.interval),
+    dead(v.dead), onDisk(v.onDisk), tag(v.tag)
+{
+  word = StringPool::share(v.word);
+  if (onDisk) {
+    text.paged = v.text.paged;
+  } else {
+    text.resident.meaning = StringPool::share(v.text.resident.meaning);
+    text.resident.explain = StringPool::share(v.text.resident.explain);
+  }
 }
 
 Voca::~Voca()
 {
-  if (word)
-    delete(word);
-  if (meaning)
-    delete(meaning);
-  if (explain)
-    delete(explain);
+  StringPool::release(word);
+  if (!onDisk) {
+    StringPool::release(text.resident.meaning);
+    StringPool::release(text.resident.explain);
+  }
 }
 
 char* Voca::getWord() {
   return word;
 }
 
-char* Voca::getMean() {
-  return meaning;
+int Voca::findTag(char* m) {
+  int len = Strlen(m);
+  if (len >= MEAN_SIZE || len < 3 || m[len - 1] != ')')
+    return 0;
+
+  int cut = len - 2;
+  while (cut > 0 && m[cut] != '(' && m[cut] != ')')
+    cut--;
+  if (cut <= 0 || m[cut] != '(' || len - cut >= TAG_SIZE)
+    return 0; // no stem, nested or too long
+  return cut;
+}
+
+char* Voca::getMean(char* buf) {
+  if (onDisk)
+    return text.paged.pager->getMean(text.paged.offset);
+  if (tag == 0)
+    return text.resident.meaning;
+
+  char *stem = text.resident.meaning;
+  char *label = StringPool::ofLabel(tag);
+  int len = 0;
+  for (int k = 0; stem[k] != '\0'; k++)
+    buf[len++] = stem[k];
+  for (int k = 0; label[k] != '\0'; k++)
+    buf[len++] = label[k];
+  buf[len] = '\0';
+  return buf;
 }
 
 char* Voca::getExplain() {
-  return explain;
+  if (onDisk)
+    return text.paged.pager->getExplain(text.paged.offset);
+  return text.resident.explain;
 }
 
 int Voca::getExp() {
@@ -249,6 +487,18 @@ int Voca::getLevel() {
   return level;
 }
 
+long Voca::getDue() {
+  return due;
+}
+
+int Voca::getInterval() {
+  return interval;
+}
+
+bool Voca::isDead() {
+  return dead;
+}
+
 void Voca::gainScore() {
   exp += (MAX_LEVEL - level + 1) * 10; // MAX_LEVEL should be lower than 10
 
@@ -260,6 +510,14 @@ void Voca::gainScore() {
       exp = 100;
     }
   }
+
+  if (interval < 1)
+    interval = 1;
+  else if (interval * 2 <= MAX_INTERVAL)
+    interval *= 2;
+  else
+    interval = MAX_INTERVAL;
+  due = time(0) + (long)interval * DAY_SECONDS;
 }
 
 void Voca::loseScore() {
@@ -273,6 +531,28 @@ void Voca::loseScore() {
       level--;
     }
   }
+
+  interval = 0;
+  due = time(0) + RETRY_DELAY;
+}
+
+void Voca::kill() {
+  dead = true;
+}
+
+bool Voca::isPaged() {
+  return onDisk;
+}
+
+void Voca::page(DeckPager* p, unsigned long long o) {
+  if (!onDisk) {
+    StringPool::release(text.resident.meaning);
+    StringPool::release(text.resident.explain);
+    onDisk = true;
+    tag = 0; // data file holds whole meaning
+  }
+  text.paged.pager = p;
+  text.paged.offset = o;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -280,6 +560,10 @@ void Voca::loseScore() {
 /// @brief VocaEngine class private fundamental functions implementation
 ///
 
+unsigned long VocaEngine::budget = 0;
+bool VocaEngine::paging = false;
+unsigned int VocaEngine::shardTarget = 0;
+
 bool VocaEngine::addVoca()
 {
   char word[100];
@@ -303,80 +587,122 @@ bool VocaEngine::addVoca()
   cin >> explain;
   cout << "#" << endl;
 
-  if (list->addNode(new Voca(word, mean, explain, 0, 1))) {
+  if (insertVoca(word, mean, explain)) {
     cout << "#    [" << word << " - " << mean << " - " << explain
          << "] ADDED!!" << endl;
     cout << "#" << endl;
-
-    if (!dirty)
-      dirty = true;
     return true;
   }
 
   return false;
 }
 
+bool VocaEngine::insertVoca(char* w, char* m, char* e)
+{
+  Voca *voca = new Voca(w, m, e, 0, 1, 0, 0);
+  if (!list->addNode(voca)) {
+    delete(voca);
+    return false;
+  }
+
+  indexVoca(voca);
+  linkVoca(table->getSize() - 1);
+  snapshots->publish();
+
+  markDirty(voca);
+  return true;
+}
+
 bool VocaEngine::initList()
 {
   if (list)
     delete(list);
   
   list = new List <Voca*>();
+  table->clear();
+  sampler->clear();
+  scheduler->clear();
+  order->clear();
+  neighbors->clear();
+  snapshots->clear();
+  snapshots->publish();
+  for (int v = VIEW_WORD; v < VIEWS; v++)
+    views[v]->clear();
+  live->clear();
+  dead = 0;
+  generation++;
+  layout++;
   
-  if (!dirty)
-    dirty = true;
+  for (unsigned int k = 0; k < shards; k++)
+    shardDirty[k] = true; // every shard becomes empty
+  dirty = true;
+  return true;
 }
 
 bool VocaEngine::saveChange()
 {
   ofstream *o = NULL;
   if (dirty) {
-    o = new ofstream(FILENAME); 
+    PROBE_START(probe);
+    compact(); // tombstones are not written
+    if (shards > 1) {
+      if (!saveShards()) { // dirty shards are written again next time
+        PROBE_STOP(SAVE, probe);
+        return false;
+      }
+      removeStale();
+      for (unsigned int k = 0; k < shards; k++)
+        shardDirty[k] = false;
+      dirty = false;
+      history->flush();
+      PROBE_STOP(SAVE, probe);
+      return true;
+    }
+
+    // old file stays until new one is complete, pager reads it meanwhile
+    char *temp = Strjoin(filename, (char*)".tmp");
+    Array <unsigned long long> offsets;
+    o = new ofstream(temp); 
+    DeckWriter writer(o);
+    char mean[Voca::MEAN_SIZE];
     
-    for (unsigned int i = 0; i < list->getSize(); i++) {
-      char* word = list->getContent(i)->getWord();
-      char* meaning = list->getContent(i)->getMean();
-      char* explain = list->getContent(i)->getExplain();
-      char* exp_str = IntToStr(list->getContent(i)->getExp());
-      char* level_str = IntToStr(list->getContent(i)->getLevel());
+    // walk nodes, getContent(i) would walk from head for every entry
+    ListNode <Voca*> *cur = list->getHead()->getNext();
+    for (; cur != list->getHead(); cur = cur->getNext()) {
+      Voca *voca = cur->getContent();
+      if (pager && !offsets.add((unsigned long long)o->tellp())) {
+        cout << "#    DATA SAVING ERROR" << endl;
+        exit(1);
+      }
       
 #if TRACE_SAVE
-      cout << "#    write " << word << " " << meaning << " "
-           << explain << " " << exp_str << " " << level_str << endl;
+      cout << "#    write " << voca->getWord() << " " << voca->getMean(mean) << " "
+           << voca->getExplain() << " " << voca->getExp() << " "
+           << voca->getLevel() << endl;
 #endif
 
-      int pnt = 0;
-      while(word[pnt] != '\0') {
-        o->put(word[pnt++]);
-      }
-      o->put('%');
-
-      pnt = 0;
-      while(meaning[pnt] != '\0') {
-        o->put(meaning[pnt++]);
-      }
-      o->put('%');
-
-      pnt = 0;
-      while(explain[pnt] != '\0') {
-        o->put(explain[pnt++]);
-      }
-      o->put('%');
-
-      pnt = 0;
-      while(exp_str[pnt] != '\0') {
-        o->put(exp_str[pnt++]);
-      }
-      o->put('%');
-
-      pnt = 0;
-      while(level_str[pnt] != '\0') {
-        o->put(level_str[pnt++]);
-      }
-      o->put('$');
+      writer.write(voca->getWord(), voca->getMean(mean), voca->getExplain(),
+                   voca->getExp(), voca->getLevel(), voca->getDue(),
+                   voca->getInterval());
     }
     
     o->close();
+    bool good = o->good() && rename(temp, filename) == 0;
+    delete(o);
+    if (!good)
+      remove(temp);
+    delete[] temp;
+    if (!good) {
+      PROBE_STOP(SAVE, probe);
+      return false;
+    }
+    if (pager && pager->remap(filename))
+      pageText(&offsets);
+    removeStale();
+    shardDirty[0] = false;
+    dirty = false;
+    history->flush();
+    PROBE_STOP(SAVE, probe);
     
     return true;
   } else {
@@ -385,224 +711,1095 @@ bool VocaEngine::saveChange()
   return false;
 }
 
-Voca* VocaEngine::selectVoca() {
-  srand(time(0));
-  int index = rand() % list->getSize();
-
-  while (!levelPenalty(list->getContent(index)))
-    index = rand() % list->getSize();
+int VocaEngine::selectVoca() {
+  PROBE_START(probe);
+  int first = scheduler->top();
+  if (first >= 0 && scheduler->getDue(first) <= time(0)) {
+    PROBE_STOP(SELECT, probe);
+    return first; // overdue word has priority
+  }
 
-  return list->getContent(index);
+  int index = sampler->sample();
+  PROBE_STOP(SELECT, probe);
+  return index;
 }
 
-bool VocaEngine::levelPenalty(Voca* voca) {
-  srand(time(0));
-  int coefficient = (rand() % voca->MAX_LEVEL) + 1; // 1 ~ MAX_LEVEL
-  
-  if ((voca->getLevel() - coefficient) <= 0)
-    return true; // means select
-  else
-    return false; // means unselect
+int VocaEngine::drawBatch(int *out, int n, bool weighted) {
+  int size = table->getSize();
+  if (n > size)
+    n = size;
+
+  if (!weighted) {
+    // partial Fisher-Yates, any previous permutation is a fine start
+    for (int k = 0; k < n; k++) {
+      int j = k + (int)random->below(size - k);
+      int tmp = order->get(k);
+      order->set(k, order->get(j));
+      order->set(j, tmp);
+      out[k] = order->get(k);
+    }
+    return n;
+  }
+
+  int drawn = 0;
+  while (drawn < n) {
+    int index = sampler->sample();
+    if (index < 0)
+      break;
+    out[drawn++] = index;
+    sampler->set(index, 0); // no repeat in this batch
+  }
+
+  for (int k = 0; k < drawn; k++)
+    sampler->set(out[k], levelWeight(table->get(out[k])));
+
+  return drawn;
 }
 
-bool VocaEngine::dupCheck(char* str) { // true : stop, false : continue adding
-  if (findSim(str)) {
-    cout << "#    Do you really want to proceed to add ?" << endl;
-    cout << "#    (1) Yes (2) No [Default]" << endl;
-    cout << "#" << endl;
-    cout << "#    SELECT : ";
-    char input[100]; cin >> input;
+int VocaEngine::levelWeight(Voca* voca) {
+  PROBE_COUNT(WEIGHTS, 1);
+  int weight = voca->MAX_LEVEL - voca->getLevel() + 1; // 1 ~ MAX_LEVEL
 
-    if (input[0] != '1' && input[0] != '2') {
-      cout << "#    ERROR : WRONG INPUT" << endl;
-      return true;
-    }
-    
-    if (input[0] == '1')
-      return false;
-    else
-      return true;
+  if (weight < 1)
+    return 1; // every word keeps a chance
+  return weight;
+}
+
+void VocaEngine::indexVoca(Voca* voca) {
+  if (!table->add(voca) || !sampler->add(levelWeight(voca)) ||
+      !scheduler->add(voca->getDue()) ||
+      !order->add(order->getSize()) || !neighbors->add() ||
+      !snapshots->add(voca, levelWeight(voca)) || !live->add(1) ||
+      (sorted && (!views[VIEW_WORD]->insert(voca, table->getSize() - 1) ||
+                  !views[VIEW_LEVEL]->insert(voca, table->getSize() - 1) ||
+                  !views[VIEW_EXP]->insert(voca, table->getSize() - 1) ||
+                  !views[VIEW_WEAK]->insert(voca, table->getSize() - 1)))) {
+    cout << "#    INDEX GENERATING ERROR" << endl;
+    exit(1);
   }
+  generation++;
 
-  return false;
+  if (budget)
+    enforceBudget();
 }
 
-#define SIM_THRESHOLD 20 ///< similarity threshold value as percent
+bool VocaEngine::killVoca(unsigned int index) {
+  Voca *voca = table->get(index);
+  if (!voca || voca->isDead())
+    return false;
 
-bool VocaEngine::findSim(char* str) { // true : match || similar , false : no match
-  bool ret;
+  // views are keyed by live fields, leave them before tombstone
+  for (int v = VIEW_WORD; sorted && v < VIEWS; v++)
+    views[v]->remove(voca);
+  voca->kill();
+  dead++;
 
-  Voca *match = NULL;
-  List <int*> *simList = new List <int*> (); 
-  for (int i = 0; i < list->getSize(); i++) {
-    if (Strtype(str) != Strtype(list->getContent(i)->getWord()))
-      continue;
+  live->set(index, 0);
+  sampler->set(index, 0);
+  scheduler->set(index, LONG_MAX);
+  snapshots->kill(index);
+  generation++;
+
+  markDirty(voca);
+  return true;
+}
 
-    int similarity = Strsim(list->getContent(i)->getWord(), str, Strtype(str));
+void VocaEngine::compact() {
+  if (dead == 0)
+    return;
 
-    if (similarity == 100) {  // equal
-      match = list->getContent(i);
-    } else if (similarity > SIM_THRESHOLD) {  // similar
-      int *indexNum = new int(i);
-      simList->addNode(indexNum);
+  Array <Voca*> kept;
+  int *map = new int[table->getSize() + 1]; // old slot to new slot
+  List <Voca*> *rest = new List <Voca*>();
+  for (unsigned int k = 0; k < table->getSize(); k++) {
+    Voca *voca = table->get(k);
+    if (voca->isDead()) {
+      map[k] = -1;
+      delete(voca);
+      continue;
+    }
+    map[k] = kept.getSize();
+    if (!kept.add(voca) || !rest->addNode(voca)) {
+      cout << "#    DATA GENERATING ERROR" << endl;
+      exit(1);
+    }
+  }
+  delete(list);
+  list = rest;
+
+  // neighbor lists and views are renumbered, views hold no tombstone
+  neighbors->renumber(map);
+  for (int v = VIEW_WORD; sorted && v < VIEWS; v++)
+    views[v]->renumber(map);
+  delete[] map;
+
+  // other indexes are rebuilt
+  table->clear();
+  sampler->clear();
+  scheduler->clear();
+  order->clear();
+  snapshots->clear();
+  live->clear();
+  for (unsigned int k = 0; k < kept.getSize(); k++) {
+    Voca *voca = kept.get(k);
+    if (!table->add(voca) || !sampler->add(levelWeight(voca)) ||
+        !scheduler->add(voca->getDue()) || !order->add(k) ||
+        !snapshots->add(voca, levelWeight(voca)) || !live->add(1)) {
+      cout << "#    INDEX GENERATING ERROR" << endl;
+      exit(1);
     }
   }
+  snapshots->publish();
 
-  if (match) {
-    cout << "#" << endl;
-    cout << "#    MATCH WORD FOUND !" << endl;
-    cout << "#" << endl;
-    cout << "#    " << match->getWord() << " [" << match->getExplain() << "] : "
-      << match->getMean() << endl;
+  dead = 0;
+  generation++;
+  layout++;
+}
 
-    ret = true;
+/// @brief shard files read or written by pool threads
+struct ShardJob
+{
+  char **names;                 ///< file name of each shard
+  Array <Voca*> *part;          ///< vocabularies of each shard
+  bool *todo;                   ///< whether each shard is written
+  int *status;                  ///< reader status of each shard, -1 if written badly
+};
+
+static void loadShard(void* arg, int, unsigned int first, unsigned int last) {
+  ShardJob *job = (ShardJob*)arg;
+
+  for (unsigned int k = first; k < last; k++) {
+    ifstream in(job->names[k]);
+    DeckReader reader(&in);
+    int status;
+    while ((status = reader.next()) > 0) {
+      Voca *voca = new Voca(reader.getWord(), reader.getMean(),
+                            reader.getExplain(), reader.getExp(),
+                            reader.getLevel(), reader.getDue(),
+                            reader.getInterval());
+      if (!job->part[k].add(voca)) {
+        delete(voca);
+        status = -1;
+        break;
+      }
+    }
+    job->status[k] = status;
   }
+}
 
-  if (simList->getSize() > 0) {
-    cout << "#" << endl;
-    cout << "#    SIMILAR WORD FOUND !" << endl;
-    cout << "#" << endl;
-    for (int i = 0; i < simList->getSize(); i++) {
-      int index = *(simList->getContent(i));
-      cout << "#    " << list->getContent(index)->getWord() << " [" 
-        << list->getContent(index)->getExplain() << "] : "
-        << list->getContent(index)->getMean() << endl;
+static void saveShard(void* arg, int, unsigned int first, unsigned int last) {
+  ShardJob *job = (ShardJob*)arg;
+  char mean[Voca::MEAN_SIZE];
+
+  for (unsigned int k = first; k < last; k++) {
+    job->status[k] = 1;
+    if (!job->todo[k])
+      continue;
+
+    // old shard stays until new one is complete
+    char *temp = Strjoin(job->names[k], (char*)".tmp");
+    ofstream out(temp);
+    DeckWriter writer(&out);
+    for (unsigned int i = 0; i < job->part[k].getSize(); i++) {
+      Voca *voca = job->part[k].get(i);
+      writer.write(voca->getWord(), voca->getMean(mean), voca->getExplain(),
+                   voca->getExp(), voca->getLevel(), voca->getDue(),
+                   voca->getInterval());
+    }
+    out.close();
+    if (!out.good() || rename(temp, job->names[k]) != 0) {
+      remove(temp);
+      job->status[k] = -1;
     }
+    delete[] temp;
+  }
+}
 
-    ret = true;
+unsigned int VocaEngine::shardOf(Voca* voca) {
+  if (shards == 1)
+    return 0;
+  return (unsigned int)(Strhash(voca->getWord(), 14695981039346656037ULL)
+                        % shards);
+}
+
+void VocaEngine::markDirty(Voca* voca) {
+  shardDirty[shardOf(voca)] = true;
+  dirty = true;
+}
+
+bool VocaEngine::loadShards() {
+  ShardJob job;
+  job.names = new char*[stored];
+  job.part = new Array <Voca*>[stored];
+  job.todo = NULL;
+  job.status = new int[stored];
+  for (unsigned int k = 0; k < stored; k++)
+    job.names[k] = DeckShards::name(filename, k, stored);
+
+  if (!pool) // threads are kept for later scans
+    pool = new WorkPool(0);
+  pool->run(stored, 1, loadShard, &job);
+
+  // indexes are built by this thread, in shard order
+  bool loaded = false;
+  for (unsigned int k = 0; k < stored; k++) {
+    if (job.status[k] < 0) {
+      cout << "#    DATA FILE ERROR" << endl;
+      exit(1);
+    }
+    for (unsigned int i = 0; i < job.part[k].getSize(); i++) {
+      Voca *voca = job.part[k].get(i);
+      if (!list->addNode(voca)) {
+        cout << "#    DATA GENERATING ERROR" << endl;
+        exit(1);
+      }
+      indexVoca(voca);
+      loaded = true;
+    }
+    delete[] job.names[k];
   }
 
-  if (match == NULL && simList->getSize() == 0) {
-    cout << "#" << endl;
-    cout << "#    NO MATCH WORD !" << endl;
+  delete[] job.names;
+  delete[] job.part;
+  delete[] job.status;
+  return loaded;
+}
 
-    ret = false;
+bool VocaEngine::saveShards() {
+  ShardJob job;
+  job.names = new char*[shards];
+  job.part = new Array <Voca*>[shards];
+  job.todo = shardDirty;
+  job.status = new int[shards];
+  for (unsigned int k = 0; k < shards; k++)
+    job.names[k] = DeckShards::name(filename, k, shards);
+
+  // list order within each shard, clean shards are left alone
+  ListNode <Voca*> *cur = list->getHead()->getNext();
+  for (; cur != list->getHead(); cur = cur->getNext()) {
+    Voca *voca = cur->getContent();
+    unsigned int s = shardOf(voca);
+    if (shardDirty[s] && !job.part[s].add(voca)) {
+      cout << "#    DATA GENERATING ERROR" << endl;
+      exit(1);
+    }
   }
-  cout << "#" << endl;
 
-  delete (simList);
-  
-  return ret;
+  if (!pool) // threads are kept for later scans
+    pool = new WorkPool(0);
+  pool->run(shards, 1, saveShard, &job);
+
+  bool good = true;
+  for (unsigned int k = 0; k < shards; k++) {
+    good = good && job.status[k] > 0;
+    delete[] job.names[k];
+  }
+  delete[] job.names;
+  delete[] job.part;
+  delete[] job.status;
+  return good;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-///
-/// @brief VocaEngine class private abstract functions implementation
-///
+void VocaEngine::removeStale() {
+  if (stored == shards)
+    return;
 
-void VocaEngine::printTitle(void) {
-  cout << "#######################################################" << endl; // 50 sharps
-  cout << "#                     VOCAMASTER" << endl;
-  cout << "#                       v." << VERSION << endl;
-  cout << "#                  made by Suwon Oh" << endl;
-  cout << "#" << endl;  
+  if (stored == 1) {
+    remove(filename);
+  } else {
+    // last shard first, so an interrupted removal leaves no gap
+    for (unsigned int k = stored; k > ((shards > 1) ? shards : 0); k--) {
+      char *name = DeckShards::name(filename, k - 1, stored);
+      remove(name);
+      delete[] name;
+    }
+  }
+  stored = shards;
 }
 
-void VocaEngine::printEnd(void) {
-  cout << "#" << endl;
-  cout << "#######################################################" << endl; // 50 sharps
+void VocaEngine::pageText(Array <unsigned long long> *offsets) {
+  snapshots->clear();
+  for (unsigned int k = 0; k < table->getSize(); k++) {
+    Voca *voca = table->get(k);
+    voca->page(pager, offsets->get(k));
+    if (!snapshots->add(voca, levelWeight(voca))) {
+      cout << "#    INDEX GENERATING ERROR" << endl;
+      exit(1);
+    }
+  }
+  snapshots->publish();
 }
 
-void VocaEngine::manageList(int index) {
-  int tag = 1; // new index
-  ListNode <Voca*> *cur = list->getNode(index);
-  bool hasPrev = (index != 0) ? true : false;
-  bool hasNext = false;
- 
-  if (!cur) { // empty list
-    cout << "#" << endl;
-    cout << "#             EMPTY LIST" << endl;
-    cout << "#" << endl;
+void VocaEngine::accountMemory(unsigned long *bytes) {
+  unsigned int slots = table->getSize();
+
+  bytes[MEM_NODES] = (slots + 1) * sizeof(ListNode <Voca*>);
+  bytes[MEM_VOCA] = slots * sizeof(Voca);
+  bytes[MEM_STRINGS] = StringPool::getBytes();
+  if (pager)
+    bytes[MEM_STRINGS] += pager->getBytes();
+  bytes[MEM_TABLE] = table->getBytes() + order->getBytes();
+  bytes[MEM_SELECT] = sampler->getBytes() + live->getBytes()
+    + scheduler->getBytes();
+  bytes[MEM_NEIGHBORS] = neighbors->getBytes();
+  bytes[MEM_SNAPSHOT] = Snapshot::bytesOf(slots); // copies share strings
+  bytes[MEM_VIEWS] = 0;
+  for (int v = VIEW_WORD; v < VIEWS; v++)
+    bytes[MEM_VIEWS] += views[v]->getBytes();
+  bytes[MEM_QUERIES] = queries->getBytes();
+  bytes[MEM_DICT] = dict->getBytes();
+}
+
+void VocaEngine::enforceBudget() {
+  if (getFootprint() <= budget)
     return;
+
+  // cheapest to rebuild first
+  if (queries->getSize() > 0) {
+    queries->clear();
+    drops++;
+    if (getFootprint() <= budget)
+      return;
   }
 
-  cout << "#               [ LIST ]" << endl;
-  while (cur != list->getHead() && tag <= 10) {
-    Voca *curVoca = cur->getContent();
-    cout << "#    [" << tag++ << "] ";
-    cout << curVoca->getWord() << " - " << curVoca->getMean() << endl;
-    cur = cur->getNext();
+  if (sorted) {
+    for (int v = VIEW_WORD; v < VIEWS; v++)
+      views[v]->clear();
+    sorted = false;
+    drops++;
   }
-  
-  if (cur != list->getHead() && tag == 11)
-    hasNext = true;
+}
 
-  cout << "#" << endl;
-  cout << "#             [ LIST MENU ]" << endl;
-  cout << "#    (1) DELETE" << endl;
-  cout << "#    (2) INITIALIZATION" << endl;
-  cout << "#    (3) CANCEL" << endl;
-  if (hasPrev && hasNext) {
-    cout << "#    (4) <=" << endl;
-    cout << "#    (5) =>" << endl;
+void VocaEngine::buildViews() {
+  for (unsigned int k = 0; k < table->getSize(); k++) {
+    Voca *voca = table->get(k);
+    if (voca->isDead())
+      continue;
+    if (!views[VIEW_WORD]->insert(voca, k) ||
+        !views[VIEW_LEVEL]->insert(voca, k) ||
+        !views[VIEW_EXP]->insert(voca, k) ||
+        !views[VIEW_WEAK]->insert(voca, k)) {
+      cout << "#    INDEX GENERATING ERROR" << endl;
+      exit(1);
+    }
+  }
+  sorted = true;
+}
+
+/// @brief list slot of word dictionary build
+struct DictSlot
+{
+  Voca *voca;                   ///< vocabulary
+  int index;                    ///< list index
+};
+
+static int bySlotWord(DictSlot a, DictSlot b) {
+  return Strcmp(a.voca->getWord(), b.voca->getWord());
+}
+
+void VocaEngine::buildDict() {
+  adoptDict(true);
+  if (dictGeneration == generation)
+    return;
+
+  Array <DictSlot> slots;
+  for (unsigned int k = 0; k < table->getSize(); k++) {
+    DictSlot slot;
+    slot.voca = table->get(k);
+    slot.index = k;
+    if (!slot.voca->isDead())
+      slots.add(slot);
+  }
+  slots.sort(bySlotWord); // stable, so same words keep list order
+
+  dict->clear();
+  for (unsigned int k = 0; k < slots.getSize(); k++) {
+    if (!dict->add(slots.get(k).voca->getWord(), slots.get(k).index)) {
+      cout << "#    INDEX GENERATING ERROR" << endl;
+      exit(1);
+    }
+  }
+  dictGeneration = generation;
+  dictLayout = layout;
+  dictCover = table->getSize();
+  dictSaved = false;
+}
+
+/// @brief background dictionary build, shared by engine and its thread
+struct DictBuild
+{
+  SnapshotIndex *snapshots;     ///< source of words
+  WordDict *dict;               ///< result
+  unsigned long layout;         ///< slot layout when build started
+  unsigned int cover;           ///< slots of snapshot which dict was built from
+  bool good;                    ///< whether every word was added
+  volatile bool done;           ///< set by thread when dict is complete
+};
+
+static void* dictWorker(void* arg) {
+  DictBuild *build = (DictBuild*)arg;
+  int ticket;
+  Snapshot *snap = build->snapshots->acquire(ticket);
+
+  Array <DictSlot> slots;
+  for (unsigned int k = 0; k < snap->getSize(); k++) {
+    DictSlot slot;
+    slot.voca = snap->get(k);
+    slot.index = k;
+    if (!slot.voca->isDead())
+      slots.add(slot);
+  }
+  slots.sort(bySlotWord);
+
+  bool good = true;
+  for (unsigned int k = 0; good && k < slots.getSize(); k++)
+    good = build->dict->add(slots.get(k).voca->getWord(), slots.get(k).index);
+  build->cover = snap->getSize();
+  build->snapshots->release(ticket);
+
+  build->good = good; // dropped if not, rebuilt on demand
+  __sync_synchronize(); // dict is complete before done is seen
+  build->done = true;
+  return NULL;
+}
+
+void VocaEngine::startDict() {
+  if (dictBuild)
+    return;
+
+  dictBuild = new DictBuild();
+  dictBuild->snapshots = snapshots;
+  dictBuild->dict = new WordDict();
+  dictBuild->layout = layout;
+  dictBuild->cover = 0;
+  dictBuild->good = false;
+  dictBuild->done = false;
+  dictTarget = generation; // snapshot is published for this generation
+  if (pthread_create(&dictThread, NULL, dictWorker, dictBuild) != 0) {
+    delete(dictBuild->dict);
+    delete(dictBuild);
+    dictBuild = NULL; // findWord builds it in place later
+  }
+}
+
+void VocaEngine::adoptDict(bool wait) {
+  if (!dictBuild || (!wait && !dictBuild->done))
+    return;
+
+  pthread_join(dictThread, NULL);
+  if (dictBuild->good && dictBuild->layout == layout) {
+    // words added meanwhile are scanned after it until next build
+    delete(dict);
+    dict = dictBuild->dict;
+    dictLayout = layout;
+    dictCover = dictBuild->cover;
+    bool exact = dictTarget == generation && dictCover == table->getSize();
+    dictGeneration = exact ? generation : ULONG_MAX;
+    dictSaved = false;
+  } else { // slots renumbered meanwhile
+    delete(dictBuild->dict);
+  }
+  delete(dictBuild);
+  dictBuild = NULL;
+}
+
+void VocaEngine::saveDict() {
+  adoptDict(true);
+  if (dictGeneration != generation || dictSaved)
+    return;
+
+  // other processes may map old file, so it is replaced, not truncated
+  char *temp = Strjoin(dictFilename, (char*)".tmp");
+  ofstream *o = new ofstream(temp, ios::out | ios::binary);
+  dict->save(o, deckStamp(), table->getSize());
+  o->close();
+  dictSaved = o->good() && rename(temp, dictFilename) == 0;
+  delete(o);
+  delete[] temp;
+}
+
+int VocaEngine::similarity(Voca* a, Voca* b) {
+  if (Strtype(a->getWord()) != Strtype(b->getWord()))
+    return 0;
+
+  return Strsim(a->getWord(), b->getWord(), Strtype(a->getWord()));
+}
+
+void VocaEngine::buildNeighbors(unsigned int index) {
+  Voca *voca = table->get(index);
+
+  neighbors->reset(index);
+  for (unsigned int j = 0; j < table->getSize(); j++) {
+    if (j == index || table->get(j)->isDead())
+      continue;
+
+    int sim = similarity(voca, table->get(j));
+    if (sim > 0 && sim < 100) // same word is no distractor
+      neighbors->offer(index, j, sim);
+  }
+}
+
+void VocaEngine::linkVoca(unsigned int index) {
+  Voca *voca = table->get(index);
+
+  neighbors->reset(index);
+  for (unsigned int j = 0; j < table->getSize(); j++) {
+    if (j == index || table->get(j)->isDead())
+      continue;
+
+    int sim = similarity(voca, table->get(j));
+    if (sim > 0 && sim < 100) {
+      neighbors->offer(index, j, sim);
+      if (neighbors->isKnown(j))
+        neighbors->offer(j, index, sim);
+    }
+  }
+}
+
+int VocaEngine::getDistractors(unsigned int index, int *out) {
+  if (!neighbors->isKnown(index))
+    buildNeighbors(index);
+
+  int count = neighbors->get(index, out);
+
+  // fill up with random words, tries are bounded for tiny list
+  int want = NeighborIndex::K;
+  if (want > (int)table->getSize() - 1)
+    want = table->getSize() - 1;
+  for (int tries = 0; count < want && tries < 8 * NeighborIndex::K; tries++) {
+    int other = (int)random->below(table->getSize());
+    bool fresh = (other != (int)index);
+    for (int k = 0; fresh && k < count; k++)
+      fresh = (out[k] != other);
+    if (fresh)
+      out[count++] = other;
+  }
+
+  return count;
+}
+
+unsigned long long VocaEngine::deckStamp() {
+  unsigned long long hash = 14695981039346656037ULL;
+  char separator[2] = { '%', '\0' };
+
+  for (unsigned int i = 0; i < table->getSize(); i++) {
+    if (table->get(i)->isDead())
+      continue;
+    hash = Strhash(table->get(i)->getWord(), hash);
+    hash = Strhash(separator, hash);
+  }
+
+  return hash;
+}
+
+void VocaEngine::saveNeighbors() {
+  if (!neighbors->isDirty())
+    return;
+
+  // lists may be mapped from old file, so it is replaced, not truncated
+  char *temp = Strjoin(simFilename, (char*)".tmp");
+  ofstream *o = new ofstream(temp, ios::out | ios::binary);
+  neighbors->save(o, deckStamp());
+  o->close();
+  if (!o->good() || rename(temp, simFilename) != 0)
+    remove(temp); // old file stays, it is checked by its own stamp
+  delete(o);
+  delete[] temp;
+}
+
+long VocaEngine::holdVoca(unsigned int index) {
+  long due = scheduler->getDue(index);
+
+  scheduler->set(index, LONG_MAX);
+  sampler->set(index, 0);
+
+  return due;
+}
+
+void VocaEngine::releaseVoca(unsigned int index, long due) {
+  scheduler->set(index, due);
+  sampler->set(index, levelWeight(table->get(index)));
+}
+
+/// @name list view orders, ties broken by word
+/// @{
+static int byWord(Voca* a, Voca* b) {
+  return Strcmp(a->getWord(), b->getWord());
+}
+
+static int byLevel(Voca* a, Voca* b) { // highest level first
+  if (a->getLevel() != b->getLevel())
+    return (a->getLevel() > b->getLevel()) ? -1 : 1;
+  return byWord(a, b);
+}
+
+static int byExp(Voca* a, Voca* b) { // highest exp first
+  if (a->getExp() != b->getExp())
+    return (a->getExp() > b->getExp()) ? -1 : 1;
+  return byWord(a, b);
+}
+
+static int byWeakness(Voca* a, Voca* b) { // lowest level, exp, due first
+  if (a->getLevel() != b->getLevel())
+    return (a->getLevel() < b->getLevel()) ? -1 : 1;
+  if (a->getExp() != b->getExp())
+    return (a->getExp() < b->getExp()) ? -1 : 1;
+  if (a->getDue() != b->getDue())
+    return (a->getDue() < b->getDue()) ? -1 : 1;
+  return byWord(a, b);
+}
+/// @}
+
+static long nextMidnight(time_t now) {
+  struct tm day;
+  localtime_r(&now, &day);
+  day.tm_hour = 0; day.tm_min = 0; day.tm_sec = 0;
+  day.tm_mday++;
+  day.tm_isdst = -1;
+  return (long)mktime(&day);
+}
+
+void VocaEngine::refreshBacklog() {
+  time_t now = time(0);
+  if (now < scheduler->getHorizon())
+    return;
+
+  long horizon = nextMidnight(now);
+  scheduler->setHorizon(horizon);
+  snapshots->setHorizon(horizon);
+  snapshots->publish();
+}
+
+void VocaEngine::scoreVoca(unsigned int index, bool success, unsigned int ms) {
+  Voca *voca = table->get(index);
+  if (!voca)
+    return;
+
+  // level before scoring is the level which was tested
+  history->append(voca->getWord(), time(0), voca->getLevel(), success, ms);
+
+  // score keys change, word stays
+  for (int v = VIEW_LEVEL; sorted && v < VIEWS; v++)
+    views[v]->remove(voca);
+
+  if (success)
+    voca->gainScore();
+  else
+    voca->loseScore();
+
+  for (int v = VIEW_LEVEL; sorted && v < VIEWS; v++)
+    views[v]->insert(voca, index);
+  sampler->set(index, levelWeight(voca));
+  scheduler->set(index, voca->getDue());
+  snapshots->set(index, voca, levelWeight(voca));
+  snapshots->answer(success);
+  snapshots->publish();
+
+  markDirty(voca);
+}
+
+bool VocaEngine::dupCheck(char* str) { // true : stop, false : continue adding
+  if (findSim(str)) {
+    cout << "#    Do you really want to proceed to add ?" << endl;
+    cout << "#    (1) Yes (2) No [Default]" << endl;
+    cout << "#" << endl;
+    cout << "#    SELECT : ";
+    char input[100]; cin >> input;
+
+    if (input[0] != '1' && input[0] != '2') {
+      cout << "#    ERROR : WRONG INPUT" << endl;
+      return true;
+    }
+    
+    if (input[0] == '1')
+      return false;
+    else
+      return true;
+  }
+
+  return false;
+}
+
+/// @brief similarity scan shared by pool threads
+struct SimScan
+{
+  Array <Voca*> *table;         ///< scanned words
+  char *str;                    ///< target string
+  int type;                     ///< string type of target
+  Array <int> *similar;         ///< similar indexes per thread
+  Array <int> *score;           ///< similarity per thread
+  int *match;                   ///< last same index per thread
+  int *chunkThread;             ///< thread which scanned each chunk
+  unsigned int *chunkBegin;     ///< first buffer entry of each chunk
+  unsigned int *chunkEnd;       ///< buffer entry after each chunk
+};
+
+static void scanChunk(void* arg, int thread, unsigned int first,
+                      unsigned int last) {
+  SimScan *s = (SimScan*)arg;
+  unsigned int c = first / SCAN_CHUNK;
+
+  s->chunkThread[c] = thread;
+  s->chunkBegin[c] = s->similar[thread].getSize();
+  for (unsigned int i = first; i < last; i++) {
+    if (s->table->get(i)->isDead())
+      continue;
+    char *word = s->table->get(i)->getWord();
+    if (Strtype(word) != s->type)
+      continue;
+
+    PROBE_START(probe);
+    int sim = Strsim(word, s->str, s->type);
+    PROBE_STOP(STRSIM, probe);
+    PROBE_COUNT(CANDIDATES, 1);
+
+    if (sim == 100) {  // equal
+      if ((int)i > s->match[thread])
+        s->match[thread] = i;
+    } else if (sim > SIM_THRESHOLD) {  // similar
+      s->similar[thread].add(i);
+      s->score[thread].add(sim);
+    }
+  }
+  s->chunkEnd[c] = s->similar[thread].getSize();
+}
+
+int VocaEngine::scanSim(char* str, Array <int> *similar, Array <int> *score) {
+  int match = -1;
+  PROBE_START(probe);
+  char *query = Strtrim(str); // same result for same trimmed query
+  if (queries->find(query, generation, match, similar, score)) {
+    delete[] query;
+    PROBE_STOP(FINDSIM, probe);
+    return match;
+  }
+
+  match = scanAll(query, similar, score);
+  queries->store(query, generation, match, similar, score);
+  delete[] query;
+  if (budget)
+    enforceBudget();
+  PROBE_STOP(FINDSIM, probe);
+  return match;
+}
+
+int VocaEngine::scanAll(char* str, Array <int> *similar, Array <int> *score) {
+  int match = -1;
+
+  if (table->getSize() >= SCAN_PARALLEL) {
+    if (!pool) // threads are kept for later scans
+      pool = new WorkPool(0);
+
+    if (pool->getThreads() > 1) {
+      int threads = pool->getThreads();
+      unsigned int size = table->getSize();
+      unsigned int chunks = (size + SCAN_CHUNK - 1) / SCAN_CHUNK;
+      SimScan s;
+      s.table = table;
+      s.str = str;
+      s.type = Strtype(str);
+      s.similar = new Array <int>[threads];
+      s.score = new Array <int>[threads];
+      s.match = new int[threads];
+      s.chunkThread = new int[chunks];
+      s.chunkBegin = new unsigned int[chunks];
+      s.chunkEnd = new unsigned int[chunks];
+      for (int t = 0; t < threads; t++)
+        s.match[t] = -1;
+
+      pool->run(size, SCAN_CHUNK, scanChunk, &s);
+
+      // chunk order is index order, same as serial scan
+      for (unsigned int c = 0; c < chunks; c++) {
+        int t = s.chunkThread[c];
+        for (unsigned int k = s.chunkBegin[c]; k < s.chunkEnd[c]; k++) {
+          similar->add(s.similar[t].get(k));
+          score->add(s.score[t].get(k));
+        }
+      }
+      for (int t = 0; t < threads; t++) {
+        if (s.match[t] > match)
+          match = s.match[t];
+      }
+
+      delete[] s.similar;
+      delete[] s.score;
+      delete[] s.match;
+      delete[] s.chunkThread;
+      delete[] s.chunkBegin;
+      delete[] s.chunkEnd;
+      return match;
+    }
+  }
+
+  for (unsigned int i = 0; i < table->getSize(); i++) {
+    if (table->get(i)->isDead())
+      continue;
+    char *word = table->get(i)->getWord();
+    if (Strtype(str) != Strtype(word))
+      continue;
+
+    PROBE_START(probe);
+    int sim = Strsim(word, str, Strtype(str));
+    PROBE_STOP(STRSIM, probe);
+    PROBE_COUNT(CANDIDATES, 1);
+
+    if (sim == 100) {  // equal
+      match = i;
+    } else if (sim > SIM_THRESHOLD) {  // similar
+      similar->add(i);
+      score->add(sim);
+    }
+  }
+
+  return match;
+}
+
+int VocaEngine::findWord(char* str) {
+  adoptDict(false);
+  if (lookupGeneration != generation) {
+    lookupGeneration = generation;
+    lookups = 0;
+  }
+  if (dictGeneration != generation && ++lookups >= DICT_LOOKUPS)
+    buildDict();
+  else if (dictLayout != layout || table->getSize() - dictCover > DICT_TAIL)
+    startDict(); // scanning until it is done
+  if (dictGeneration == generation)
+    return dict->find(str);
+
+  unsigned int first = 0;
+  if (dictLayout == layout) { // slots below cover still hold same words
+    int index = dict->find(str);
+    if (index >= 0 && !table->get(index)->isDead())
+      return index;
+    if (index < 0)
+      first = dictCover; // only words added since build are unknown
+  }
+
+  for (unsigned int i = first; i < table->getSize(); i++) {
+    if (!table->get(i)->isDead() && Strequal(table->get(i)->getWord(), str))
+      return i;
+  }
+
+  return -1;
+}
+
+bool VocaEngine::findSim(char* str) { // true : match || similar , false : no match
+  char mean[Voca::MEAN_SIZE];
+  bool ret;
+
+  Array <int> simList;
+  Array <int> simScore;
+  int index = scanSim(str, &simList, &simScore);
+  Voca *match = (index >= 0) ? table->get(index) : NULL;
+
+  if (match) {
+    cout << "#" << endl;
+    cout << "#    MATCH WORD FOUND !" << endl;
     cout << "#" << endl;
-  } else if (hasPrev) {
-    cout << "#    (4) <=" << endl;
-  } else if (hasNext) {
-    cout << "#    (4) =>" << endl;
+    cout << "#    " << match->getWord() << " [" << match->getExplain() << "] : "
+      << match->getMean(mean) << endl;
+
+    ret = true;
+  }
+
+  if (simList.getSize() > 0) {
+    cout << "#" << endl;
+    cout << "#    SIMILAR WORD FOUND !" << endl;
+    cout << "#" << endl;
+    for (unsigned int i = 0; i < simList.getSize(); i++) {
+      Voca *sim = table->get(simList.get(i));
+      cout << "#    " << sim->getWord() << " [" 
+        << sim->getExplain() << "] : "
+        << sim->getMean(mean) << endl;
+    }
+
+    ret = true;
+  }
+
+  if (match == NULL && simList.getSize() == 0) {
+    cout << "#" << endl;
+    cout << "#    NO MATCH WORD !" << endl;
+
+    ret = false;
   }
   cout << "#" << endl;
 
-  cout << "#    SELECT : ";
-  char input[100];
-  cin >> input;
+  return ret;
+}
 
-  if (input[0] < '1' || input[0] > '3') {
-    if (!hasPrev && !hasNext) {
-      cout << "#    ERROR : WRONG INPUT" << endl;
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief VocaEngine class private abstract functions implementation
+///
+
+void VocaEngine::printTitle(void) {
+  cout << "#######################################################" << endl; // 50 sharps
+  cout << "#                     VOCAMASTER" << endl;
+  cout << "#                       v." << VERSION << endl;
+  cout << "#                  made by Suwon Oh" << endl;
+  cout << "#" << endl;  
+}
+
+void VocaEngine::printEnd(void) {
+  cout << "#" << endl;
+  cout << "#######################################################" << endl; // 50 sharps
+}
+
+int VocaEngine::viewSlot(int view, unsigned int rank) {
+  if (view == VIEW_INSERTED) // rank among live indexes
+    return live->find(rank);
+
+  if (!sorted && view == VIEW_WORD) { // dictionary is lighter than trees
+    buildDict();
+    return dict->get(rank);
+  }
+  if (!sorted) // dropped over budget
+    buildViews();
+  return views[view]->select(rank);
+}
+
+Voca* VocaEngine::viewGet(int view, unsigned int rank) {
+  int slot = viewSlot(view, rank);
+  return (slot >= 0) ? table->get(slot) : NULL;
+}
+
+void VocaEngine::manageList(int index) {
+  int view = VIEW_INSERTED;
+  unsigned int size = getSize();
+  char mean[Voca::MEAN_SIZE];
+
+  while (true) {
+    if (size == 0) { // empty list
+      cout << "#" << endl;
+      cout << "#             EMPTY LIST" << endl;
       cout << "#" << endl;
       return;
     }
-    else if (input[0] == '5' && (!hasPrev || !hasNext)) {
+
+    // every page is ranks [index, index + PAGE_SIZE), O(log n) each
+    int tag = 1; // new index
+    bool hasPrev = (index != 0) ? true : false;
+    bool hasNext = (index + PAGE_SIZE < (int)size) ? true : false;
+
+    cout << "#               [ LIST ]" << endl;
+    for (; tag <= PAGE_SIZE && index + tag - 1 < (int)size; tag++) {
+      Voca *curVoca = viewGet(view, index + tag - 1);
+      cout << "#    [" << tag << "] ";
+      cout << curVoca->getWord() << " - " << curVoca->getMean(mean) << endl;
+    }
+
+    cout << "#" << endl;
+    cout << "#             [ LIST MENU ]" << endl;
+    cout << "#    (1) DELETE" << endl;
+    cout << "#    (2) INITIALIZATION" << endl;
+    cout << "#    (3) CANCEL" << endl;
+    if (hasPrev && hasNext) {
+      cout << "#    (4) <=" << endl;
+      cout << "#    (5) =>" << endl;
+      cout << "#" << endl;
+    } else if (hasPrev) {
+      cout << "#    (4) <=" << endl;
+    } else if (hasNext) {
+      cout << "#    (4) =>" << endl;
+    }
+    cout << "#    (6) SORT" << endl;
+    cout << "#    (7) PAGE" << endl;
+    cout << "#" << endl;
+
+    cout << "#    SELECT : ";
+    char input[100];
+    cin >> input;
+
+    if (input[0] == '4' && !hasPrev && !hasNext) {
+      cout << "#    ERROR : WRONG INPUT" << endl;
+      cout << "#" << endl;
+      return;
+    } else if (input[0] == '5' && (!hasPrev || !hasNext)) {
+      cout << "#    ERROR : WRONG INPUT" << endl;
+      cout << "#" << endl;
+      return;
+    } else if (input[0] < '1' || input[0] > '7') {
       cout << "#    ERROR : WRONG INPUT" << endl;
       cout << "#" << endl;
       return;
     }
-  }
 
-  switch(input[0]) {
-    case '1':
-      int choice;
-      cout << "#    SELECT INDEX [NUMBER] : ";
-      cin >> choice;
-      if (choice < 1 || choice > tag-1) {
-        cout << "#    ERROR : WRONG INDEX" << endl;
-        cout << "#" << endl;
-      } else {
-        list->delNode(index + choice - 1);
-        
-        if (!dirty)
-          dirty = true;
+    switch(input[0]) {
+      case '1': {
+        int choice;
+        cout << "#    SELECT INDEX [NUMBER] : ";
+        cin >> choice;
+        if (choice < 1 || choice > tag-1) {
+          cout << "#    ERROR : WRONG INDEX" << endl;
+          cout << "#" << endl;
+          return;
+        }
+
+        // every view keeps list index of its entries
+        killVoca(viewSlot(view, index + choice - 1));
+        snapshots->publish();
+        if (dead * 2 > table->getSize())
+          compact();
 
         cout << "#    DATA DELETE" << endl;
         cout << "#" << endl;
+        return;
       }
-      break;
-    case '2':
-      char answer[100];
-      cout << "#    Are you sure ? (y,N) : ";
-      cin >> answer;
-
-      if (answer[0] == 'Y' || answer[0] == 'y') {
-        cout << "#    LIST INITIIALIZATION" << endl;
+      case '2':
+        char answer[100];
+        cout << "#    Are you sure ? (y,N) : ";
+        cin >> answer;
+
+        if (answer[0] == 'Y' || answer[0] == 'y') {
+          cout << "#    LIST INITIIALIZATION" << endl;
+          cout << "#" << endl;
+          initList();
+        }
+        return;
+      case '3':
         cout << "#" << endl;
-        initList();
+        return;
+      case '4':
+        cout << "#" << endl;
+        if (!hasPrev)
+          index += PAGE_SIZE;
+        else
+          index -= PAGE_SIZE;
+        break;
+      case '5':
+        cout << "#" << endl;
+        index += PAGE_SIZE;
+        break;
+      case '6':
+        cout << "#    (1) INSERTED (2) WORD (3) LEVEL (4) EXP (5) WEAKEST" << endl;
+        cout << "#    SORT : ";
+        cin >> input;
+        if (input[0] < '1' || input[0] > '0' + VIEWS) {
+          cout << "#    ERROR : WRONG INPUT" << endl;
+          cout << "#" << endl;
+          return;
+        }
+        cout << "#" << endl;
+        view = input[0] - '1';
+        index = 0;
+        break;
+      case '7': {
+        int page;
+        int pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+        cout << "#    PAGE [1 - " << pages << "] : ";
+        cin >> page;
+        if (page < 1 || page > pages) {
+          cout << "#    ERROR : WRONG PAGE" << endl;
+          cout << "#" << endl;
+          return;
+        }
+        cout << "#" << endl;
+        index = (page - 1) * PAGE_SIZE;
+        break;
       }
-      break;
-    case '3':
-      cout << "#" << endl;
-      break;
-    case '4':
-      cout << "#" << endl;
-      if (!hasPrev)
-        manageList(index + 10);
-      else
-        manageList(index - 10);
-      break;
-    case '5':
-      cout << "#" << endl;
-      manageList(index + 10);
-      break;
+    }
   }
 }
 
@@ -613,73 +1810,222 @@ void VocaEngine::searchVoca() {
   cout << "#" << endl;
   cout << "#    SEARCH WORD : ";
 
-  char buf[100]; cin >> buf;
-  char *search = new char[sizeof(char) * Strlen(buf) + 1];
-  Strcpy(search, buf);
-  
-  // search match & similar one
-  findSim(search);
+  char buf[100]; cin >> buf;
+  char *search = new char[sizeof(char) * Strlen(buf) + 1];
+  Strcpy(search, buf);
+  
+  // search match & similar one
+  findSim(search);
+
+  delete(search);
+}
+
+void VocaEngine::testVoca() {
+  compact(); // test indexes see live words only
+
+  if (table->getSize() == 0) {
+    cout << "#" << endl;
+    cout << "#             EMPTY LIST" << endl;
+    cout << "#" << endl;
+    return;
+  }
+
+  cout << "#             [ TEST MODE ]" << endl;
+  cout << "#    (1) NORMAL" << endl;
+  cout << "#    (2) QUIZ BATCH" << endl;
+  cout << "#    (3) MULTIPLE CHOICE" << endl;
+  cout << "#" << endl;
+  cout << "#    SELECT : ";
+  char input[100]; cin >> input;
+
+  TestSession session(this);
+  if (input[0] == '1') {
+    session.run(false);
+  } else if (input[0] == '3') {
+    session.run(true);
+  } else if (input[0] == '2') {
+    int size;
+    cout << "#    QUIZ SIZE [NUMBER] : ";
+    cin >> size;
+    if (!cin || size < 1) {
+      cin.clear();
+      cout << "#    ERROR : WRONG SIZE" << endl;
+      cout << "#" << endl;
+      return;
+    }
+
+    char answer[100];
+    cout << "#    Weighted by level ? (y,N) : ";
+    cin >> answer;
+    session.runQuiz(size, answer[0] == 'Y' || answer[0] == 'y');
+  } else {
+    cout << "#    WRONG INPUT" << endl;
+    cout << "#" << endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief TestSession class functions implementation
+///
+
+TestSession::TestSession(VocaEngine *e) : engine(e), head(0), count(0),
+  correct(0), total(0)
+{
+}
+
+TestSession::~TestSession(void)
+{
+  // words which were prefetched but never asked go back to selection
+  for (; count > 0; count--) {
+    engine->releaseVoca(slot[head], due[head]);
+    head = (head + 1) % BATCH;
+  }
+}
 
-  delete(search);
+void TestSession::prefetch(void)
+{
+  while (count < BATCH) {
+    int index = engine->selectVoca();
+    if (index < 0)
+      break; // every word is already waiting in queue
+
+    int tail = (head + count) % BATCH;
+    slot[tail] = index;
+    due[tail] = engine->holdVoca(index);
+    count++;
+  }
 }
 
-void VocaEngine::testVoca(bool first, int correct, int total) {
-  int cor = correct;
+void TestSession::ask(int index)
+{
+  char mean[Voca::MEAN_SIZE];
+  Voca *one = engine->table->get(index);
+
+  cout << "#" << endl;
+  cout << "#    " << one->getMean(mean) << " : ";
+
+  unsigned long long asked = Probe::now();
+  char answer[100]; cin >> answer;
+  unsigned int ms = (unsigned int)((Probe::now() - asked) / 1000000);
 
-  if (list->getSize() == 0) {
+  if (Strequal(one->getWord(), answer)) {
+    cout << "#    COLLECT!" << endl;
+    engine->scoreVoca(index, true, ms);
+    correct++;
     cout << "#" << endl;
-    cout << "#             EMPTY LIST" << endl;
+  } else {
+    cout << "#    WRONG!" << endl;
+    cout << "#    COLLECT ANSWER IS [" << one->getWord()
+      << " -- " << one->getExplain() << "]" << endl;
+    engine->scoreVoca(index, false, ms);
     cout << "#" << endl;
-    return;
   }
-  
-  if (first) {
-    cout << "#                [ TEST ]" << endl;
-    cout << "#    Write appropriate word matching following meanings." << endl;
+  total++;
+}
+
+void TestSession::askChoice(int index)
+{
+  char mean[Voca::MEAN_SIZE];
+  Voca *one = engine->table->get(index);
+
+  int choices[NeighborIndex::K + 1];
+  int n = engine->getDistractors(index, choices + 1) + 1;
+  choices[0] = index;
+
+  // shuffle choices so that answer position tells nothing
+  for (int k = n - 1; k > 0; k--) {
+    int j = (int)engine->random->below(k + 1);
+    int tmp = choices[k];
+    choices[k] = choices[j];
+    choices[j] = tmp;
   }
+
   cout << "#" << endl;
-  Voca *one = selectVoca();
-  cout << "#    " << one->getMean() << " : ";
-  
-  char buf[100]; cin >> buf;
-  char *answer = new char[sizeof(char) * Strlen(buf) + 1];
-  Strcpy(answer, buf);
+  cout << "#    " << one->getMean(mean) << endl;
+  for (int k = 0; k < n; k++)
+    cout << "#    (" << k + 1 << ") " << engine->table->get(choices[k])->getWord() << endl;
+  cout << "#    SELECT : ";
 
-  if (Strequal(one->getWord(), answer)) {
+  unsigned long long asked = Probe::now();
+  char answer[100]; cin >> answer;
+  unsigned int ms = (unsigned int)((Probe::now() - asked) / 1000000);
+  int pick = answer[0] - '1';
+
+  if (answer[1] == '\0' && pick >= 0 && pick < n && choices[pick] == index) {
     cout << "#    COLLECT!" << endl;
-    one->gainScore();
-    cor++;
+    engine->scoreVoca(index, true, ms);
+    correct++;
     cout << "#" << endl;
   } else {
     cout << "#    WRONG!" << endl;
     cout << "#    COLLECT ANSWER IS [" << one->getWord()
       << " -- " << one->getExplain() << "]" << endl;
-    one->loseScore();
+    engine->scoreVoca(index, false, ms);
     cout << "#" << endl;
   }
+  total++;
+}
 
-  if (!dirty)
-    dirty = true;
-  
-  cout << "#    (1) NEXT TEST (2) EXIT" << endl;
-  cout << "#    SELECT : ";
-  char sel[100]; cin >> sel;
+void TestSession::printResult(void)
+{
+  cout << "#" << endl;
+  cout << "#               [ TEST RESULT ]" << endl;
+  cout << "#    TOTAL PROBLEM  : " << total << endl;
+  cout << "#    CORRECT ANSWER : " << correct << endl;
+  cout << "#    WRONG ANSWER   : " << total - correct << endl;
+  cout << "#    SUCCESS RATE   : " << ((correct * 100) / total) << "%" << endl;
+  cout << "#" << endl;
+}
 
-  if (sel[0] != '1') {
-    if (sel[0] != '2') {
-      cout << "#    WRONG INPUT" << endl;
-      cout << "#" << endl;
+void TestSession::run(bool choice)
+{
+  cout << "#                [ TEST ]" << endl;
+  if (choice)
+    cout << "#    Choose appropriate word matching following meanings." << endl;
+  else
+    cout << "#    Write appropriate word matching following meanings." << endl;
+
+  while (true) {
+    prefetch();
+
+    int index = slot[head];
+    head = (head + 1) % BATCH;
+    count--;
+    if (choice)
+      askChoice(index);
+    else
+      ask(index);
+
+    cout << "#    (1) NEXT TEST (2) EXIT" << endl;
+    cout << "#    SELECT : ";
+    char sel[100]; cin >> sel;
+
+    if (sel[0] != '1') {
+      if (sel[0] != '2') {
+        cout << "#    WRONG INPUT" << endl;
+        cout << "#" << endl;
+      }
+      break;
     }
-    cout << "#" << endl;
-    cout << "#               [ TEST RESULT ]" << endl;
-    cout << "#    TOTAL PROBLEM  : " << total+1 << endl;
-    cout << "#    CORRECT ANSWER : " << cor << endl;
-    cout << "#    WRONG ANSWER   : " << total+1 - cor << endl;
-    cout << "#    SUCCESS RATE   : " << ((cor * 100) / (total + 1)) << "%" << endl;
-    cout << "#" << endl;
-  } else {
-    testVoca(false, cor, total+1);
   }
+
+  printResult();
+}
+
+void TestSession::runQuiz(int n, bool weighted)
+{
+  int *batch = new int[n];
+  n = engine->drawBatch(batch, n, weighted);
+
+  cout << "#                [ QUIZ ]" << endl;
+  cout << "#    " << n << " words, each asked once." << endl;
+
+  for (int k = 0; k < n; k++)
+    ask(batch[k]);
+
+  delete[] batch;
+  printResult();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -687,102 +2033,119 @@ void VocaEngine::testVoca(bool first, int correct, int total) {
 /// @brief VocaEngine class constructors and destructors implementation
 ///
 
-VocaEngine::VocaEngine(istream *i)
+VocaEngine::VocaEngine(char* file, bool q)
 {
-  printTitle();
+  quiet = q;
+  nextDeck = NULL;
   
   bool loaded = false;
+  PROBE_START(probe);
+
+  filename = new char[sizeof(char) * Strlen(file) + 1];
+  Strcpy(filename, file);
+  simFilename = Strjoin(filename, (char*)SIM_SUFFIX);
+  dictFilename = Strjoin(filename, (char*)DICT_SUFFIX);
+  stored = DeckShards::count(filename);
+  if (stored == 0) {
+    cout << "#    DATA FILE ERROR : SHARD MISSING" << endl;
+    exit(1);
+  }
+  shards = shardTarget ? shardTarget : stored;
+  shardDirty = new bool[shards];
+  for (unsigned int k = 0; k < shards; k++)
+    shardDirty[k] = (stored != shards); // new layout writes every shard
+  pager = (paging && stored == 1 && shards == 1) ? new DeckPager(filename)
+                                                 : NULL;
+  char *logFilename = Strjoin(filename, (char*)LOG_SUFFIX);
+  history = new HistoryWriter(logFilename);
+  delete[] logFilename;
 
   list = new List <Voca*>();
+  table = new Array <Voca*>();
+  random = new Random();
+  sampler = new Sampler(random);
+  scheduler = new Scheduler();
+  order = new Array <int>();
+  neighbors = new NeighborIndex();
+  snapshots = new SnapshotIndex();
+  snapshots->setHorizon(nextMidnight(time(0))); // backlog counted while loading
+  pool = NULL;
+  queries = new QueryCache(QUERY_CACHE);
+  live = new Sampler(random);
+  dead = 0;
+  views[VIEW_INSERTED] = NULL; // table keeps insertion order
+  views[VIEW_WORD] = new OrderTree(byWord);
+  views[VIEW_LEVEL] = new OrderTree(byLevel);
+  views[VIEW_EXP] = new OrderTree(byExp);
+  views[VIEW_WEAK] = new OrderTree(byWeakness);
+  sorted = true;
+  drops = 0;
+  dict = new WordDict();
+  dictGeneration = lookupGeneration = ULONG_MAX; // no generation yet
+  dictLayout = ULONG_MAX; // no dictionary yet
+  dictCover = 0;
+  dictTarget = ULONG_MAX; // no build started
+  lookups = 0;
+  dictBuild = NULL;
+  dictSaved = false;
+  generation = 0;
+  layout = 0;
   dirty = false;
 
-  while (!i->eof() && !i->bad() && i->peek() != -1) {
-    if (!loaded) // flag on
-      loaded = true;
-
-    // fill out previous list
-    char word[100];
-    char mean[100];
-    char explain[100];
-    char exp_buf[100];
-    char level_buf[100];
-    int exp, level;
-
-    // get word
-    int index = 0;
-    while (i->peek() != '%' && i->peek() != '$' && !i->eof() && !i->bad())
-      word[index++] = i->get();
-    word[index] = '\0';
-    
-    if (i->peek() == '%') {
-      i->get(); // consume token
-    } else { // i->eof() || i->bad() || i->peek() == '$'
-      cout << "#    DATA FILE ERROR" << endl;
-      exit(1);
-    }
-    
-    // get mean
-    index = 0;
-    while (i->peek() != '%' && i->peek() != '$' && !i->eof() && !i->bad())
-      mean[index++] = i->get();
-    mean[index] = '\0';
-    
-    if (i->peek() == '%') {
-      i->get(); // consume token
-    } else { // i->eof() || i->bad() || i->peek() == '$'
-      cout << "#    DATA FILE ERROR" << endl;
-      exit(1);
-    }
-
-    // get explain
-    index = 0;
-    while (i->peek() != '%' && i->peek() != '$' && !i->eof() && !i->bad())
-      explain[index++] = i->get();
-    explain[index] = '\0';
-    
-    if (i->peek() == '%') {
-      i->get(); // consume token
-    } else { // i->eof() || i->bad() || i->peek() == '$'
-      cout << "#    DATA FILE ERROR" << endl;
-      exit(1);
+  if (stored > 1) {
+    loaded = loadShards();
+  } else {
+    ifstream *i = new ifstream(filename);
+    DeckReader reader(i);
+    int status;
+    while ((status = reader.next()) > 0) {
+      if (!loaded) // flag on
+        loaded = true;
+
+      // fill out previous list
+      Voca *voca;
+      if (pager && pager->isOpen())
+        voca = new Voca(reader.getWord(), pager, reader.getOffset(),
+                        reader.getExp(), reader.getLevel(), reader.getDue(),
+                        reader.getInterval());
+      else
+        voca = new Voca(reader.getWord(), reader.getMean(),
+                        reader.getExplain(), reader.getExp(),
+                        reader.getLevel(), reader.getDue(),
+                        reader.getInterval());
+      if (!list->addNode(voca)) {
+        cout << "#    DATA GENERATING ERROR" << endl;
+        exit(1);
+      }
+      indexVoca(voca);
     }
 
-    // get exp
-    index = 0;
-    while (i->peek() != '%' && i->peek() != '$' && !i->eof() && !i->bad())
-      exp_buf[index++] = i->get();
-    exp_buf[index] = '\0';
-    exp = StrToInt(exp_buf);
-    
-    if (i->peek() == '%') {
-      i->get(); // consume token
-    } else { // i->eof() || i->bad() || i->peek() == '$'
+    if (status < 0) {
       cout << "#    DATA FILE ERROR" << endl;
       exit(1);
     }
+    i->close();
+    delete(i);
+  }
+  if (loaded && stored != shards)
+    dirty = true; // rewritten in new layout at exit
+  snapshots->publish(); // whole deck becomes visible at once
+  PROBE_STOP(LOAD, probe);
+
+  unsigned long long stamp = deckStamp();
+  neighbors->map(simFilename, stamp);
+
+  // saved dictionary is read in place, otherwise built on first lookup
+  if (dict->map(dictFilename, stamp, table->getSize())) {
+    dictGeneration = generation;
+    dictLayout = layout;
+    dictCover = table->getSize();
+    dictSaved = true;
+  }
 
-    // get level
-    index = 0;
-    while (i->peek() != '%' && i->peek() != '$' && !i->eof() && !i->bad())
-      level_buf[index++] = i->get();
-    level_buf[index] = '\0';
-    level = StrToInt(level_buf);
-
-    if (!list->addNode(new Voca(word, mean, explain, exp, level))) {
-      cout << "#    DATA GENERATING ERROR" << endl;
-      exit(1);
-    }
-
-    if (i->peek() == '$') {
-      i->get(); // consume token
-    } else { // i->eof() || i->bad() || i->peek() != '%'
-      cout << "#    DATA FILE ERROR" << endl;
-      exit(1);
-    }
+  if (quiet)
+    return;
 
-    while (isWhite(i->peek()))
-      i->get(); // consume white space
-  }
   if (loaded)
     cout << "#    DATA FILE LOADING COMPLETE" << endl;
   else // no prev data
@@ -793,15 +2156,54 @@ VocaEngine::VocaEngine(istream *i)
 
 VocaEngine::~VocaEngine()
 {
-  if(saveChange())
-    cout << "#    SAVE DATA..." << endl;
-  else
-    cout << "#    NO UPDATE" << endl;
+  bool saved = saveChange();
+  saveNeighbors();
+  saveDict();
+
+  if (!quiet) {
+    if (saved)
+      cout << "#    SAVE DATA..." << endl;
+    else if (dirty)
+      cout << "#    DATA SAVING ERROR" << endl;
+    else
+      cout << "#    NO UPDATE" << endl;
+  }
 
   if (list)
     delete(list);
-
-  printEnd();
+  if (table)
+    delete(table);
+  if (sampler)
+    delete(sampler);
+  if (scheduler)
+    delete(scheduler);
+  if (order)
+    delete(order);
+  if (neighbors)
+    delete(neighbors);
+  if (snapshots)
+    delete(snapshots);
+  if (pool)
+    delete(pool);
+  if (queries)
+    delete(queries);
+  for (int v = VIEW_WORD; v < VIEWS; v++)
+    delete(views[v]);
+  if (dict)
+    delete(dict);
+  if (live)
+    delete(live);
+  if (random)
+    delete(random);
+  if (pager) // paged vocabularies are gone
+    delete(pager);
+  delete(history);
+  delete[] shardDirty;
+  delete[] filename;
+  delete[] simFilename;
+  delete[] dictFilename;
+  if (nextDeck)
+    delete[] nextDeck;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -809,14 +2211,99 @@ VocaEngine::~VocaEngine()
 /// @brief VocaEngine class public abstract control functions implementation
 ///
 
+unsigned int VocaEngine::getSize(void)
+{
+  return (unsigned int)live->getTotal();
+}
+
+bool VocaEngine::isDirty(void)
+{
+  return dirty;
+}
+
+unsigned long VocaEngine::getFootprint(void)
+{
+  unsigned long bytes[MEM_ACCOUNTS];
+  accountMemory(bytes);
+
+  unsigned long total = sizeof(VocaEngine);
+  for (int m = 0; m < MEM_ACCOUNTS; m++)
+    total += bytes[m];
+
+  return total;
+}
+
+char* VocaEngine::takeSwitch(void)
+{
+  char *name = nextDeck;
+  nextDeck = NULL;
+  return name;
+}
+
+void VocaEngine::setBudget(unsigned long bytes)
+{
+  budget = bytes;
+}
+
+void VocaEngine::setPaged(bool on)
+{
+  paging = on;
+}
+
+void VocaEngine::setShards(unsigned int n)
+{
+  shardTarget = n;
+}
+
+void VocaEngine::setSeed(unsigned long long seed)
+{
+  random->seed(seed);
+}
+
+void VocaEngine::setQuiet(bool q)
+{
+  quiet = q;
+}
+
 void VocaEngine::showMenu()
 {
+  refreshBacklog();
+  cout << "#    " << scheduler->getBacklog() << " WORDS DUE TODAY" << endl;
+  cout << "#" << endl;
   cout << "#               [ MENU ]" << endl;
   cout << "#    (1) ADD" << endl;
   cout << "#    (2) LIST" << endl;
   cout << "#    (3) SEARCH" << endl;
   cout << "#    (4) TEST" << endl;
   cout << "#    (5) EXIT" << endl;
+  cout << "#    (6) DECK" << endl;
+  cout << "#    (7) STATS" << endl;
+  cout << "#" << endl;
+}
+
+void VocaEngine::showStats()
+{
+  refreshBacklog();
+
+  int ticket;
+  Snapshot *snap = snapshots->acquire(ticket);
+  DeckStats stats = snap->getStats();
+  unsigned int size = snap->getLive();
+  snapshots->release(ticket);
+
+  cout << "#               [ STATS ]" << endl;
+  cout << "#    WORDS : " << size << endl;
+  for (int level = 1; level <= Voca::MAX_LEVEL; level++)
+    cout << "#    LEVEL " << level << " : " << stats.perLevel[level] << endl;
+  cout << "#    AVERAGE EXP : " << (size ? stats.expSum / size : 0) << endl;
+  cout << "#    MASTERED : " << stats.mastered << endl;
+  cout << "#    DUE TODAY : " << stats.backlog << endl;
+  cout << "#    SESSION ACCURACY : ";
+  if (stats.answered)
+    cout << stats.correct * 100 / stats.answered << "% (" << stats.correct
+      << "/" << stats.answered << ")" << endl;
+  else
+    cout << "-" << endl;
   cout << "#" << endl;
 }
 
@@ -832,7 +2319,7 @@ bool VocaEngine::processMenu()
   char mean[100];
   cin >> input;
 
-  if (input[0] < '1' || input[0] > '5') {
+  if (input[0] < '1' || input[0] > '7') {
     cout << "#    WRONG INPUT" << endl;
     cout << "#" << endl;
     return true;
@@ -857,7 +2344,7 @@ bool VocaEngine::processMenu()
       good = true;
       break;
     case '4':
-      testVoca(true, 0, 0);
+      testVoca();
       good = true;
       break;
     case '5':
@@ -865,7 +2352,369 @@ bool VocaEngine::processMenu()
       cout << "#" << endl;
       good = false;
       break;
+    case '6':
+      cout << "#    DECK NAME : ";
+      cin.width(sizeof(word));
+      cin >> word;
+      if (nextDeck)
+        delete[] nextDeck;
+      nextDeck = new char[sizeof(char) * Strlen(word) + 1];
+      Strcpy(nextDeck, word);
+      good = false;
+      break;
+    case '7':
+      showStats();
+      good = true;
+      break;
   }
 
   return good;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief VocaEngine class public batch control functions implementation
+///
+
+bool VocaEngine::cmdSearch(char* word, ostream* o)
+{
+  char mean[Voca::MEAN_SIZE];
+  int ticket;
+  Snapshot *snap = snapshots->acquire(ticket);
+
+  // same scan as scanAll, serial over snapshot, cache and pool are writer's
+  Array <int> simList;
+  Array <int> simScore;
+  int index = -1;
+  char *query = Strtrim(word);
+  int type = Strtype(query);
+  for (unsigned int i = 0; i < snap->getSize(); i++) {
+    if (snap->get(i)->isDead())
+      continue;
+    char *other = snap->get(i)->getWord();
+    if (type != Strtype(other))
+      continue;
+
+    PROBE_START(probe);
+    int sim = Strsim(other, query, type);
+    PROBE_STOP(STRSIM, probe);
+    PROBE_COUNT(CANDIDATES, 1);
+    if (sim == 100) {  // equal
+      index = i;
+    } else if (sim > SIM_THRESHOLD) {  // similar
+      simList.add(i);
+      simScore.add(sim);
+    }
+  }
+  delete[] query;
+
+  if (index >= 0) {
+    Voca *match = snap->get(index);
+    *o << "match\t" << word << "\t100\t" << match->getWord() << "\t"
+      << match->getMean(mean) << "\t" << match->getExplain() << "\n";
+  }
+
+  for (unsigned int k = 0; k < simList.getSize(); k++) {
+    Voca *sim = snap->get(simList.get(k));
+    *o << "similar\t" << word << "\t" << simScore.get(k) << "\t"
+      << sim->getWord() << "\t" << sim->getMean(mean) << "\t"
+      << sim->getExplain() << "\n";
+  }
+  snapshots->release(ticket);
+
+  if (index < 0 && simList.getSize() == 0) {
+    *o << "none\t" << word << "\n";
+    return false;
+  }
+  return true;
+}
+
+static inline bool validField(char* str) {
+  if (Strlen(str) >= FIELD_SIZE)
+    return false; // data file loading would overflow
+
+  for (int k = 0; str[k] != '\0'; k++) {
+    if (str[k] == '%' || str[k] == '$')
+      return false; // data file delimiters
+  }
+
+  return true;
+}
+
+bool VocaEngine::cmdAdd(char* w, char* m, char* e, ostream* o)
+{
+  if (w[0] == '\0' || !validField(w) || !validField(m) || !validField(e)) {
+    *o << "invalid\t" << w << "\n";
+    return false;
+  }
+
+  if (findWord(w) >= 0) {
+    *o << "exists\t" << w << "\n";
+    return false;
+  }
+
+  if (!insertVoca(w, m, e)) {
+    *o << "error\t" << w << "\n";
+    return false;
+  }
+
+  *o << "added\t" << w << "\n";
+  return true;
+}
+
+int VocaEngine::cmdDelete(char** words, int n, ostream* o)
+{
+  // every word is found before first kill moves generation
+  int *found = new int[n];
+  for (int k = 0; k < n; k++)
+    found[k] = findWord(words[k]);
+
+  int deleted = 0;
+  for (int k = 0; k < n; k++) {
+    if (found[k] >= 0 && killVoca(found[k])) {
+      *o << "deleted\t" << words[k] << "\n";
+      deleted++;
+    } else {
+      *o << "none\t" << words[k] << "\n";
+    }
+  }
+  delete[] found;
+
+  snapshots->publish();
+  if (dead * 2 > table->getSize())
+    compact();
+  return deleted;
+}
+
+bool VocaEngine::cmdList(int page, ostream* o)
+{
+  char mean[Voca::MEAN_SIZE];
+  int ticket;
+  Snapshot *snap = snapshots->acquire(ticket);
+
+  unsigned int first = (page - 1) * PAGE_SIZE;
+  if (page < 1 || (first >= snap->getLive() && first > 0)) {
+    snapshots->release(ticket);
+    return false;
+  }
+
+  // numbers count live entries only
+  unsigned int rank = 0;
+  for (unsigned int k = 0; k < snap->getSize() && rank < first + PAGE_SIZE; k++) {
+    Voca *voca = snap->get(k);
+    if (voca->isDead() || rank++ < first)
+      continue;
+    *o << rank << "\t" << voca->getWord() << "\t" << voca->getMean(mean)
+      << "\t" << voca->getExplain() << "\t" << voca->getExp()
+      << "\t" << voca->getLevel() << "\n";
+  }
+  snapshots->release(ticket);
+  return true;
+}
+
+void VocaEngine::cmdStats(ostream* o)
+{
+  long horizon = nextMidnight(time(0));
+
+  int ticket;
+  Snapshot *snap = snapshots->acquire(ticket);
+  DeckStats stats = snap->getStats();
+  unsigned int size = snap->getLive();
+  if (stats.horizon != horizon) { // day passed and no writer moved horizon
+    stats.backlog = 0;
+    for (unsigned int k = 0; k < snap->getSize(); k++) {
+      Voca *voca = snap->get(k);
+      if (!voca->isDead() && voca->getDue() < horizon)
+        stats.backlog++;
+    }
+  }
+  snapshots->release(ticket);
+
+  *o << "words\t" << size << "\n";
+  for (int level = 1; level <= Voca::MAX_LEVEL; level++)
+    *o << "level" << level << "\t" << stats.perLevel[level] << "\n";
+  *o << "exp_sum\t" << stats.expSum << "\n";
+  *o << "due_today\t" << stats.backlog << "\n";
+  *o << "mastered\t" << stats.mastered << "\n";
+  *o << "session_answers\t" << stats.answered << "\n";
+  *o << "session_correct\t" << stats.correct << "\n";
+}
+
+void VocaEngine::cmdMemory(ostream* o)
+{
+  *o << "query_hits\t" << queries->getHits() << "\n";
+  *o << "query_misses\t" << queries->getMisses() << "\n";
+
+  const char *account[] = { "list_nodes", "voca", "strings", "table",
+                            "select", "neighbors", "snapshot", "views",
+                            "queries", "dict" };
+  unsigned long bytes[MEM_ACCOUNTS];
+  unsigned long total = sizeof(VocaEngine);
+  accountMemory(bytes);
+  for (int m = 0; m < MEM_ACCOUNTS; m++) {
+    *o << "mem_" << account[m] << "\t" << bytes[m] << "\n";
+    total += bytes[m];
+  }
+  *o << "mem_total\t" << total << "\n";
+  *o << "mem_budget\t" << budget << "\n";
+  *o << "mem_drops\t" << drops << "\n";
+}
+
+bool VocaEngine::cmdNext(ostream* o, Random* r)
+{
+  char mean[Voca::MEAN_SIZE];
+  int ticket;
+  Snapshot *snap = snapshots->acquire(ticket);
+
+  int index = snap->select(r ? r : random, (long)time(0));
+  if (index < 0) {
+    snapshots->release(ticket);
+    *o << "none\n";
+    return false;
+  }
+
+  Voca *voca = snap->get(index);
+  *o << "question\t" << voca->getWord() << "\t" << voca->getMean(mean) << "\t"
+    << voca->getExplain() << "\t" << voca->getExp() << "\t"
+    << voca->getLevel() << "\n";
+  snapshots->release(ticket);
+  return true;
+}
+
+bool VocaEngine::cmdScore(char* word, bool success, ostream* o)
+{
+  int index = findWord(word);
+  if (index < 0) {
+    *o << "none\t" << word << "\n";
+    return false;
+  }
+
+  scoreVoca(index, success, 0);
+
+  Voca *voca = table->get(index);
+  *o << "scored\t" << word << "\t" << voca->getExp() << "\t"
+    << voca->getLevel() << "\n";
+  return true;
+}
+
+void VocaEngine::cmdSave(ostream* o)
+{
+  if (saveChange())
+    *o << "saved\n";
+  else if (dirty)
+    *o << "error\tsave failed\n";
+  else
+    *o << "unchanged\n";
+}
+
+int VocaEngine::cmdImport(istream *i, ostream *report, int threads)
+{
+  char mean[Voca::MEAN_SIZE];
+  RecordReader reader(i);
+  WordHash words;
+  Array <Voca*> batch;
+  Array <unsigned long> lines;
+  int duplicate = 0, similar = 0, invalid = 0;
+
+  compact(); // slots below are plain table indexes
+  unsigned int size = table->getSize();
+  for (unsigned int k = 0; k < size; k++)
+    words.insert(table->get(k)->getWord(), k);
+
+  // stream records, dropping invalid ones and exact duplicates
+  while (reader.next()) {
+    char *w = reader.getField(0);
+    char *m = reader.getField(1);
+    char *e = reader.getField(2);
+
+    if (reader.isHeader()) {
+      *report << "header\t" << reader.getLine() << "\t" << w << "\n";
+      continue;
+    }
+
+    if (reader.getFields() != RecordReader::FIELDS || w[0] == '\0' ||
+        !validField(w) || !validField(m) || !validField(e)) {
+      *report << "invalid\t" << reader.getLine() << "\t" << w << "\n";
+      invalid++;
+      continue;
+    }
+
+    int index = words.find(w);
+    if (index >= 0) {
+      Voca *same = (index < (int)size) ? table->get(index)
+                                       : batch.get(index - size);
+      *report << "duplicate\t" << reader.getLine() << "\t" << w << "\t"
+        << same->getMean(mean) << "\n";
+      duplicate++;
+      continue;
+    }
+
+    Voca *voca = new Voca(w, m, e, 0, 1, 0, 0);
+    words.insert(voca->getWord(), size + batch.getSize());
+    batch.add(voca);
+    lines.add(reader.getLine());
+  }
+
+  // similarity against existing words, in parallel
+  char **base = new char*[size + 1];
+  char **query = new char*[batch.getSize() + 1];
+  int *floor = new int[size + 1];
+  for (unsigned int k = 0; k < size; k++) {
+    base[k] = table->get(k)->getWord();
+    floor[k] = neighbors->getFloor(k);
+  }
+  for (unsigned int k = 0; k < batch.getSize(); k++)
+    query[k] = batch.get(k)->getWord();
+
+  // neighbor numbers of scan are list indexes after batch is appended
+  SimilarityScan scan(base, size, query, batch.getSize(), SIM_THRESHOLD);
+  scan.setNeighbors(NeighborIndex::K, floor);
+  scan.run(threads);
+
+  for (unsigned int k = 0; k < batch.getSize(); k++) {
+    Voca *voca = batch.get(k);
+
+    if (scan.getBest(k) >= 0) {
+      *report << "similar\t" << lines.get(k) << "\t" << voca->getWord()
+        << "\t" << scan.getScore(k) << "\t" << base[scan.getBest(k)] << "\n";
+      similar++;
+    }
+
+    if (!list->addNode(voca)) {
+      cout << "#    DATA GENERATING ERROR" << endl;
+      exit(1);
+    }
+    indexVoca(voca);
+    markDirty(voca);
+  }
+
+  // scored pairs are offered both ways, as linkVoca does for one word
+  int near[NeighborIndex::K];
+  int sims[NeighborIndex::K];
+  for (unsigned int k = 0; k < batch.getSize(); k++) {
+    unsigned int index = size + k;
+    neighbors->reset(index);
+    int count = scan.getNear(k, near, sims);
+    for (int n = 0; n < count; n++)
+      neighbors->offer(index, near[n], sims[n]);
+    for (unsigned int n = 0; n < scan.getLinks(k); n++) {
+      int sim;
+      int other = scan.getLink(k, n, sim);
+      neighbors->offer(other, index, sim);
+    }
+  }
+
+  delete[] base;
+  delete[] query;
+  delete[] floor;
+
+  snapshots->publish();
+
+  *report << "imported\t" << batch.getSize() << "\n";
+  *report << "duplicate\t" << duplicate << "\n";
+  *report << "similar\t" << similar << "\n";
+  *report << "invalid\t" << invalid << "\n";
+  report->flush();
+
+  return batch.getSize();
+}
@@ -22,6 +22,19 @@
 #include <iostream>
 #include <fstream>
 #include "list.h"
+#include "array.h"
+#include "sampler.h"
+#include "scheduler.h"
+#include "neighbor.h"
+#include "wordhash.h"
+#include "snapshot.h"
+#include "pool.h"
+#include "querycache.h"
+#include "ordertree.h"
+#include "intern.h"
+#include "dict.h"
+#include "pager.h"
+#include "history.h"
 
 using namespace std;
 
@@ -33,20 +46,55 @@ using namespace std;
 ///          Class. It is a data-based class. 'exp' & 'level' are informations @n
 ///          about user's frequency of the vocabulary. Higher 'level' means that @n
 ///          user remember this word well. Answering collectly in test, user can @n
-///          gain 'exp' score from VocaEngine, and this score upgrades Voca's level.
+///          gain 'exp' score from VocaEngine, and this score upgrades Voca's level. @n
+///          'due' & 'interval' schedule next review (Leitner style). Correct @n
+///          answer doubles interval, wrong answer resets it and brings the @n
+///          word back after RETRY_DELAY seconds. Strings are taken from @n
+///          StringPool and shared with every Voca of same text. Trailing @n
+///          "(...)" tag of meaning is split off and kept as one byte label, @n
+///          so tags like "(한자)" are stored once for whole deck.
 /// 
 
 class Voca
 {
 private:
   char* word;               ///< Vocabulary word
-  char* meaning;            ///< Vocabulary meaning (in your language)
-  char* explain;            ///< Vocabulary additional explanation
+  union
+  {
+    struct
+    {
+      char* meaning;        ///< Vocabulary meaning (in your language)
+      char* explain;        ///< Vocabulary additional explanation
+    } resident;             ///< strings kept in memory
+    struct
+    {
+      DeckPager* pager;     ///< pager of data file
+      unsigned long long offset; ///< record offset in data file
+    } paged;                ///< strings read from data file when asked
+  } text;                   ///< meaning and explanation
   int exp;                  ///< Vocabulary experience gauge
   int level;                ///< Vocabulary level information
+  long due;                 ///< Next review time (seconds since epoch)
+  int interval;             ///< Review interval in days (0 : learning)
+  bool dead;                ///< Tombstone, deleted but not compacted yet
+  bool onDisk;              ///< whether text is paged
+  unsigned char tag;        ///< label of meaning tag, 0 if none (in padding)
+
+  /// @brief finding trailing "(...)" tag of meaning
+  ///
+  /// @param m meaning string
+  /// @retval tag offset in m, 0 if meaning has no tag to split
+  static int findTag(char* m);
+
+  /// @brief assignment is not supported, strings are shared by reference
+  Voca& operator=(const Voca& v);
 
 public:
   static const int MAX_LEVEL = 5;  ///< Maximum level range
+  static const int MAX_INTERVAL = 128;  ///< Maximum review interval in days
+  static const int RETRY_DELAY = 600;   ///< Review delay after wrong answer
+  static const int MEAN_SIZE = 100;     ///< meaning buffer size, as data field
+  static const int TAG_SIZE = 32;       ///< longer tag stays in meaning
   
   /// @name constructors
   /// @{
@@ -55,21 +103,41 @@ public:
   /// @details Defined for empty Voca instance
   Voca();
 
-  /// @brief constructor having w, m, e, x, and l
+  /// @brief constructor having w, m, e, x, l, d, and v
   /// @details Defined for creating fill-out Voca instance
   /// @param w word string
   /// @param m meaning string
   /// @param e explanation string
   /// @param x experience score
   /// @param l level point
-  Voca(char* w, char* m, char* e, int x, int l);
+  /// @param d next review time, 0 if it is due right now
+  /// @param v review interval in days
+  Voca(char* w, char* m, char* e, int x, int l, long d, int v);
+
+  /// @brief constructor having w, p, o, x, l, d, and v
+  /// @details Defined for paged Voca instance, whose meaning and @n
+  ///          explanation stay in data file
+  /// @param w word string
+  /// @param p pager of data file
+  /// @param o record offset in data file
+  /// @param x experience score
+  /// @param l level point
+  /// @param d next review time, 0 if it is due right now
+  /// @param v review interval in days
+  Voca(char* w, DeckPager* p, unsigned long long o, int x, int l, long d,
+       int v);
+
+  /// @brief copy constructor
+  /// @details Copy shares strings of v instead of hashing them again.
+  /// @param v original vocabulary
+  Voca(const Voca& v);
   /// @}
 
   /// @name destructor
   /// @{
 
   /// @brief default destructor
-  /// @details Deleting its strings
+  /// @details Releasing its strings to StringPool
   ~Voca();
   /// @}
 
@@ -82,12 +150,17 @@ public:
   /// @retval word string
   char* getWord(void);
 
-  /// @brief getting meaning string
+  /// @brief getting meaning string, tag included
+  /// @details Paged string is valid until pager reads other records, @n
+  ///          so it is printed or copied right away. Tagged meaning is @n
+  ///          joined in buf, which caller owns, so threads never share it.
   ///
-  /// @retval meaning string
-  char* getMean(void);
+  /// @param buf buffer of MEAN_SIZE characters
+  /// @retval meaning string, buf or pooled string
+  char* getMean(char* buf);
 
   /// @brief getting explanation
+  /// @details Paged string is valid until pager reads other records.
   ///
   /// @retval explanation string
   char* getExplain(void);
@@ -101,6 +174,26 @@ public:
   ///
   /// @retval level point
   int getLevel(void);
+
+  /// @brief getting next review time
+  ///
+  /// @retval seconds since epoch
+  long getDue(void);
+
+  /// @brief getting review interval
+  ///
+  /// @retval interval in days
+  int getInterval(void);
+
+  /// @brief checking tombstone
+  ///
+  /// @retval true if vocabulary is deleted
+  bool isDead(void);
+
+  /// @brief checking whether meaning and explanation are paged
+  ///
+  /// @retval true if they are read from data file
+  bool isPaged(void);
   /// @}
   
   /// @name functional attributes
@@ -108,13 +201,26 @@ public:
 
   /// @brief gaining experience score
   /// @details If test success, this word gain experience score @n
-  ///          and have a chance to get upper level point.
+  ///          and have a chance to get upper level point. @n
+  ///          Review interval doubles, up to MAX_INTERVAL days.
   void gainScore(void);
 
   /// @brief losing experience score
   /// @details If test fail, this word lose experience score @n
-  ///          and might be lowered its level point.
+  ///          and might be lowered its level point. @n
+  ///          Review interval resets, next review after RETRY_DELAY.
   void loseScore(void);
+
+  /// @brief marking vocabulary deleted
+  /// @details It stays in memory until engine compacts deck.
+  void kill(void);
+
+  /// @brief moving meaning and explanation to data file
+  /// @details Resident strings are released to StringPool.
+  ///
+  /// @param p pager of data file
+  /// @param o record offset in data file
+  void page(DeckPager* p, unsigned long long o);
   /// @}
 };
 
@@ -126,11 +232,83 @@ public:
 ///          (details on "list.h" at same folder).
 ///
 
+class TestSession;
+class Benchmark;
+struct DictBuild;
+
 class VocaEngine
 {
+  friend class TestSession;
+  friend class Benchmark;
+
 private:
+  /// @name list views
+  /// @{
+  static const int VIEW_INSERTED = 0;  ///< insertion order
+  static const int VIEW_WORD = 1;      ///< alphabetical order
+  static const int VIEW_LEVEL = 2;     ///< highest level first
+  static const int VIEW_EXP = 3;       ///< highest exp first
+  static const int VIEW_WEAK = 4;      ///< lowest level, exp and due first
+  static const int VIEWS = 5;          ///< the number of views
+  /// @}
+
+  /// @name memory accounts
+  /// @{
+  static const int MEM_NODES = 0;      ///< list nodes
+  static const int MEM_VOCA = 1;       ///< Voca objects of list
+  static const int MEM_STRINGS = 2;    ///< StringPool, shared by every engine
+  static const int MEM_TABLE = 3;      ///< table and order arrays
+  static const int MEM_SELECT = 4;     ///< sampler, live and scheduler
+  static const int MEM_NEIGHBORS = 5;  ///< neighbor index
+  static const int MEM_SNAPSHOT = 6;   ///< published version and its copies
+  static const int MEM_VIEWS = 7;      ///< sorted list views (rebuildable)
+  static const int MEM_QUERIES = 8;    ///< query cache (rebuildable)
+  static const int MEM_DICT = 9;       ///< front coded word dictionary
+  static const int MEM_ACCOUNTS = 10;  ///< the number of accounts
+  /// @}
+
+  static unsigned long budget; ///< memory budget of each engine, 0 if unlimited
+  static bool paging;     ///< whether new engines page meaning and explanation
+  static unsigned int shardTarget; ///< shard count of new engines, 0 keeps files
+
   List <Voca*> *list;     ///< Voca class list
+  Array <Voca*> *table;   ///< random access mirror of list (same order)
+  Random *random;         ///< random generator seeded once
+  Sampler *sampler;       ///< level weighted sampler (same order as list)
+  Scheduler *scheduler;   ///< due-time queue (same order as list)
+  Array <int> *order;     ///< permutation of indexes for quiz shuffle
+  NeighborIndex *neighbors; ///< similar words per index (same order as list)
+  SnapshotIndex *snapshots; ///< versions for concurrent readers (same order as list)
+  WorkPool *pool;         ///< threads of split similarity scan, NULL until used
+  QueryCache *queries;    ///< recent scan results by query
+  Sampler *live;          ///< weight 1 per live index, 0 per tombstone (same order as list)
+  unsigned int dead;      ///< the number of tombstones
+  OrderTree *views[VIEWS]; ///< sorted list views, NULL for insertion order
+  bool sorted;            ///< whether views are built, false after budget drop
+  unsigned long drops;    ///< the number of indexes dropped over budget
+  WordDict *dict;         ///< sorted live words to index, built on demand
+  unsigned long dictGeneration; ///< generation of dict, stale if it differs
+  unsigned long lookupGeneration; ///< generation of last findWord
+  unsigned int lookups;   ///< findWord calls since generation changed
+  unsigned long dictLayout; ///< layout of dict, no lookup through it if it differs
+  unsigned int dictCover; ///< slots dict was built from, later ones are scanned
+  DictBuild *dictBuild;   ///< background dictionary build, NULL if none
+  pthread_t dictThread;   ///< thread of background build
+  unsigned long dictTarget; ///< generation of background build, ULONG_MAX if none
+  bool dictSaved;         ///< whether dict file holds current dict
+  unsigned long generation; ///< bumped whenever word set or indexes change
+  unsigned long layout;   ///< bumped whenever slots are renumbered
+  char *filename;         ///< data file name
+  char *simFilename;      ///< neighbor index side file name
+  char *dictFilename;     ///< word dictionary side file name
+  DeckPager *pager;       ///< pager of data file, NULL if words are resident
+  HistoryWriter *history; ///< review log, appended by scoreVoca
+  bool quiet;             ///< no load and save messages, for batch commands
+  char *nextDeck;         ///< deck name user asked to switch to, or NULL
   bool dirty;             ///< dirty bit which means an update exists
+  unsigned int shards;    ///< shard files deck is saved into, 1 for data file
+  unsigned int stored;    ///< shard files deck was loaded from
+  bool *shardDirty;       ///< dirty bit per shard
   
   /// @name private fundamental functional attributes
   /// @{
@@ -141,6 +319,15 @@ private:
   /// @retval false if adding fails
   bool addVoca(void);
 
+  /// @brief adding new vocabulary without console I/O
+  ///
+  /// @param w word string
+  /// @param m meaning string
+  /// @param e explanation string
+  /// @retval true if adding success
+  /// @retval false if adding fails
+  bool insertVoca(char* w, char* m, char* e);
+
   /// @brief initializing vocabulary list
   ///
   /// @retval true if initialization success
@@ -148,21 +335,193 @@ private:
   bool initList(void);
 
   /// @brief saving updated data
+  /// @details Data file or shards are replaced only by complete files. @n
+  ///          On failure deck stays dirty and old files are kept.
   ///
   /// @retval true if save success
-  /// @retval false if save fail
+  /// @retval false if nothing changed or save fail (deck stays dirty)
   bool saveChange(void);
 
   /// @brief selecting one word
+  /// @details Earliest due word comes first if it is due, otherwise @n
+  ///          drawing from sampler. Both are O(log n), no rejection loop.
+  ///
+  /// @retval vocabulary index, -1 if list is empty
+  int selectVoca(void);
+
+  /// @brief drawing distinct words for quiz batch
+  /// @details Unweighted draw is a partial Fisher-Yates shuffle over order, @n
+  ///          which is O(n) for n words and needs no reset between batches. @n
+  ///          Weighted draw takes words from sampler one by one, zeroing @n
+  ///          each weight until the batch is complete, O(n log N).
+  ///
+  /// @param out buffer receiving vocabulary indexes
+  /// @param n the number of words wanted
+  /// @param weighted true if lower level should come more often
+  /// @retval the number of words drawn, lower than n for small list
+  int drawBatch(int *out, int n, bool weighted);
+
+  /// @brief calculating selection weight from level
+  /// @details Lower level gets higher weight, same ratio as former @n
+  ///          level penalty which passed (MAX_LEVEL - level + 1) / MAX_LEVEL.
   ///
-  /// @retval vocabulary class pointer
-  Voca* selectVoca(void);
+  /// @param voca target vocabulary
+  /// @retval selection weight
+  int levelWeight(Voca* voca);
 
-  /// @brief calculating level penalty and return boolean value
+  /// @brief registering vocabulary to index structures
+  /// @details It should be called right after list->addNode.
   ///
-  /// @retval true if this voca pass level penalty
-  /// @retval false if this voca fail level penalty
-  bool levelPenalty(Voca* voca);
+  /// @param voca added vocabulary
+  void indexVoca(Voca* voca);
+
+  /// @brief deleting vocabulary by tombstone
+  /// @details Marking it dead and hiding it from every index in O(log n), @n
+  ///          index of later vocabularies stays. Snapshot change is visible @n
+  ///          after publish, memory is freed by compact.
+  ///
+  /// @param index vocabulary index
+  /// @retval true if deleted, false if it is already dead
+  bool killVoca(unsigned int index);
+
+  /// @brief filling every account with bytes the engine holds now
+  /// @details O(1) from sizes and capacities. Indexes are writer's, @n
+  ///          so caller must not run beside a writer.
+  ///
+  /// @param bytes buffer of MEM_ACCOUNTS entries
+  void accountMemory(unsigned long *bytes);
+
+  /// @brief dropping rebuildable indexes while footprint is over budget
+  /// @details Query cache goes first, then sorted views, which viewGet @n
+  ///          builds again when list menu asks for them.
+  void enforceBudget(void);
+
+  /// @brief building sorted views from every live vocabulary
+  void buildViews(void);
+
+  /// @brief making word dictionary current, O(n log n) if it is stale
+  void buildDict(void);
+
+  /// @brief building word dictionary from published snapshot in a thread
+  /// @details Result is taken by adoptDict if no word changed meanwhile.
+  void startDict(void);
+
+  /// @brief taking result of background build when it is done
+  ///
+  /// @param wait true to wait for build, false to return if it runs
+  void adoptDict(bool wait);
+
+  /// @brief saving word dictionary into side file if it is current
+  /// @details Mapped dictionary is already saved, so file is written @n
+  ///          only if words changed or file was missing or stale.
+  void saveDict(void);
+
+  /// @name shard attributes
+  /// @{
+
+  /// @brief getting shard of vocabulary
+  /// @details Shard depends on word only, so scoring never moves a word.
+  ///
+  /// @param voca vocabulary
+  /// @retval shard number
+  unsigned int shardOf(Voca* voca);
+
+  /// @brief setting dirty bit of deck and shard of vocabulary
+  ///
+  /// @param voca changed vocabulary
+  void markDirty(Voca* voca);
+
+  /// @brief reading every shard file on pool threads
+  /// @details Shards are appended to list in shard order.
+  ///
+  /// @retval true if any record is read
+  bool loadShards(void);
+
+  /// @brief writing dirty shard files on pool threads
+  /// @details Each shard is written to a temporary file and renamed over @n
+  ///          old one only if the whole shard was written.
+  ///
+  /// @retval true if every dirty shard is written, false if any failed
+  bool saveShards(void);
+
+  /// @brief removing files of previous shard layout after it changed
+  void removeStale(void);
+  /// @}
+
+  /// @brief pointing every vocabulary at its record in saved data file
+  /// @details Snapshot copies are made again, so none keeps resident @n
+  ///          strings or offsets into previous file.
+  ///
+  /// @param offsets record offset of each index
+  void pageText(Array <unsigned long long> *offsets);
+
+  /// @brief dropping dead vocabularies from list and every index
+  /// @details O(n) at once for every tombstone. It runs at save, before @n
+  ///          test and import, and when half of list is dead.
+  void compact(void);
+
+  /// @brief holding word out of selection while it waits in a test queue
+  /// @details Its due time is pushed out of reach and its sampler weight @n
+  ///          becomes zero, so a prefetched batch has no duplicate.
+  ///
+  /// @param index vocabulary index
+  /// @retval original due time, which is needed to release the word
+  long holdVoca(unsigned int index);
+
+  /// @brief putting held word back to selection without scoring
+  ///
+  /// @param index vocabulary index
+  /// @param due original due time returned by holdVoca
+  void releaseVoca(unsigned int index, long due);
+
+  /// @brief scoring similarity between two words
+  ///
+  /// @param a vocabulary
+  /// @param b vocabulary
+  /// @retval similarity percent, 0 if words are different type
+  int similarity(Voca* a, Voca* b);
+
+  /// @brief computing neighbor list of one word by full scan
+  ///
+  /// @param index vocabulary index
+  void buildNeighbors(unsigned int index);
+
+  /// @brief computing neighbor list of newly added word
+  /// @details Same full scan as buildNeighbors, and new word is also @n
+  ///          offered to every known list on the way, O(n) in total.
+  ///
+  /// @param index vocabulary index
+  void linkVoca(unsigned int index);
+
+  /// @brief getting distractors for multiple choice question
+  /// @details Neighbor list is computed once, and later questions read it @n
+  ///          in O(K). Short list is filled with random other words.
+  ///
+  /// @param index vocabulary index of correct answer
+  /// @param out buffer of NeighborIndex::K entries
+  /// @retval the number of distractors
+  int getDistractors(unsigned int index, int *out);
+
+  /// @brief hashing every word in list order
+  /// @details Stamp of side files, which are valid only for same list.
+  ///
+  /// @retval content hash
+  unsigned long long deckStamp(void);
+
+  /// @brief saving neighbor index into side file if it changed
+  void saveNeighbors(void);
+
+  /// @brief moving backlog horizon to the end of today if day has passed
+  void refreshBacklog(void);
+
+  /// @brief applying test result to vocabulary
+  /// @details Calling gainScore or loseScore, updating index structures, @n
+  ///          and appending outcome to review log.
+  ///
+  /// @param index vocabulary index
+  /// @param success true if answer was correct
+  /// @param ms response time in milliseconds, 0 if unknown
+  void scoreVoca(unsigned int index, bool success, unsigned int ms);
 
   /// @brief duplicated checking
   ///
@@ -171,6 +530,40 @@ private:
   /// @retval false stop to add voca
   bool dupCheck(char* str);
 
+  /// @brief collecting same and similar vocabulary
+  /// @details Surrounding white space of query is trimmed, which is @n
+  ///          cache key. Words are compared case sensitively, as duplicate @n
+  ///          check, findWord and neighbor similarity do. Answered from @n
+  ///          query cache while deck generation is unchanged.
+  ///
+  /// @param str target string
+  /// @param similar array receiving similar vocabulary indexes
+  /// @param score array receiving similarity of each similar index
+  /// @retval index of same word, -1 if there is none
+  int scanSim(char* str, Array <int> *similar, Array <int> *score);
+
+  /// @brief scanning every vocabulary for scanSim, bypassing query cache
+  ///
+  /// @param str trimmed target string
+  /// @param similar array receiving similar indexes
+  /// @param score array receiving similarity of each similar index
+  /// @retval index of same word, -1 if there is none
+  int scanAll(char* str, Array <int> *similar, Array <int> *score);
+
+  /// @brief finding vocabulary of exactly same word
+  /// @details Stale word dictionary is still used while no slot is @n
+  ///          renumbered, and only words added since it was built are @n
+  ///          scanned. It is rebuilt in background once DICT_TAIL words @n
+  ///          are added past it or slots are renumbered, and in place once @n
+  ///          deck is read-mostly again, that is after DICT_LOOKUPS calls @n
+  ///          without change. If no dictionary file was mapped, first call @n
+  ///          starts building it, so commands which never look up a word @n
+  ///          neither build nor save it.
+  ///
+  /// @param str target string
+  /// @retval index of same word, -1 if there is none
+  int findWord(char* str);
+
   /// @brief finding similar vocabulary
   ///
   /// @param str target string
@@ -182,36 +575,45 @@ private:
   /// @name private abstract functional attributes
   /// @{
 
-  /// @brief printing title to console
-  void printTitle(void);
-
-  /// @brief printing ending to console
-  void printEnd(void);
-
   /// @brief managing list menu
+  /// @details Pages are shown in a loop; any view can be sorted and any @n
+  ///          page reached without walking list.
   ///
   /// @param index starting voca list index
   void manageList(int index);
 
+  /// @brief getting list index of rank in list view
+  ///
+  /// @param view VIEW_INSERTED, VIEW_WORD, VIEW_LEVEL, VIEW_EXP or VIEW_WEAK
+  /// @param rank 0 for first entry of view
+  /// @retval list index, -1 if rank is out of range
+  int viewSlot(int view, unsigned int rank);
+
+  /// @brief getting vocabulary of rank in list view
+  ///
+  /// @param view VIEW_INSERTED, VIEW_WORD, VIEW_LEVEL, VIEW_EXP or VIEW_WEAK
+  /// @param rank 0 for first entry of view
+  /// @retval vocabulary, NULL if rank is out of range
+  Voca* viewGet(int view, unsigned int rank);
+
   /// @brief searching a vocabulary in the list
   void searchVoca(void);
   
   /// @brief vocabulary test function
-  ///
-  /// @param first flag whether this test is first time
-  /// @param correct correct answer counts
-  /// @param total total test counts
-  void testVoca(bool first, int correct, int total);
+  /// @details Choosing test mode and running one TestSession.
+  void testVoca(void);
   /// @}
 
 public:
   /// @name constructors
   /// @{
 
-  /// @brief constructor having istream pointer
+  /// @brief constructor having data file name
   /// @details Loading previous vocabulary data list @n
   ///          and initialize all member variables.
-  VocaEngine(istream *i);
+  /// @param file data file name
+  /// @param q true if load and save messages should not be printed
+  VocaEngine(char* file, bool q);
   /// @}
 
   /// @name destructors
@@ -222,13 +624,80 @@ public:
   ///          and delete all data in memory.
   ~VocaEngine(void);
   /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of vocabulary
+  unsigned int getSize(void);
+
+  /// @brief checking whether changes are not saved yet
+  bool isDirty(void);
+
+  /// @brief getting memory which the engine holds
+  /// @details Sum of every account of accountMemory.
+  ///
+  /// @retval bytes
+  unsigned long getFootprint(void);
+
+  /// @brief taking deck name which user chose in menu
+  /// @details processMenu returns false when user switches deck too, and @n
+  ///          this tells switching from exit.
+  ///
+  /// @retval new deck name string which caller deletes, NULL if none
+  char* takeSwitch(void);
+  /// @}
   
   /// @name abstract control attributes
   /// @{
 
+  /// @brief printing title to console
+  static void printTitle(void);
+
+  /// @brief printing ending to console
+  static void printEnd(void);
+
+  /// @brief setting memory budget of every engine
+  /// @details Over budget, engine drops rebuildable indexes instead of @n
+  ///          growing them. Words themselves are always kept.
+  ///
+  /// @param bytes budget in bytes, 0 if unlimited
+  static void setBudget(unsigned long bytes);
+
+  /// @brief setting paged mode of engines created later
+  /// @details Paged engine keeps words and scores in memory, and reads @n
+  ///          meaning and explanation from data file when they are shown. @n
+  ///          Pager is not shared by threads, so server engines stay @n
+  ///          resident.
+  ///
+  /// @param on true for paged mode
+  static void setPaged(bool on);
+
+  /// @brief setting shard count of engines created later
+  /// @details Deck whose files have another count is rewritten in new @n
+  ///          layout at next save. 1 gives single data file.
+  ///
+  /// @param n the number of shards, 0 keeps layout found on disk
+  static void setShards(unsigned int n);
+
+  /// @brief setting random seed
+  /// @details Same seed with same data file gives same test questions.
+  ///
+  /// @param seed seed value
+  void setSeed(unsigned long long seed);
+
+  /// @brief setting whether load and save messages are printed
+  ///
+  /// @param q true if they should not be printed
+  void setQuiet(bool q);
+
   /// @brief showing menu to console
   void showMenu(void);
 
+  /// @brief showing deck statistics to console
+  /// @details Aggregates kept by snapshot are printed, so deck is not walked.
+  void showStats(void);
+
   /// @brief processing menu with user
   /// @details communicating with user through console I/O
   ///
@@ -236,6 +705,188 @@ public:
   /// @retval false if program termination
   bool processMenu(void);
   /// @}
+
+  /// @name batch control attributes
+  /// @details One line per result, fields separated by tab, no prompt. @n
+  ///          search, list, stats and next read published snapshot, so any @n
+  ///          number of threads may call them while one thread writes. @n
+  ///          add, score, save and import are called by one thread at a time.
+  /// @{
+
+  /// @brief searching a word
+  /// @details Printing "match", "similar" or "none" line(s) of @n
+  ///          query, score, word, meaning, explanation. Query is @n
+  ///          trimmed as scanSim does, but snapshot is scanned serially @n
+  ///          by calling thread : query cache and work pool belong to @n
+  ///          writer, and readers call this without lock.
+  ///
+  /// @param word target word
+  /// @param o output stream
+  /// @retval true if match || similar
+  bool cmdSearch(char* word, ostream* o);
+
+  /// @brief adding a word unless same word exists
+  /// @details Printing "added", "exists" or "invalid" line. @n
+  /// Fields are checked the same way as importing.
+  ///
+  /// @param w word string
+  /// @param m meaning string
+  /// @param e explanation string
+  /// @param o output stream
+  /// @retval true if added
+  bool cmdAdd(char* w, char* m, char* e, ostream* o);
+
+  /// @brief deleting words at once
+  /// @details Printing "deleted" or "none" line per word. Words are found @n
+  ///          by findWord before any is marked dead, so dictionary stays @n
+  ///          valid for all of them, then deletions are published together.
+  ///
+  /// @param words word strings
+  /// @param n the number of words
+  /// @param o output stream
+  /// @retval the number of deleted words
+  int cmdDelete(char** words, int n, ostream* o);
+
+  /// @brief printing ten words of a page
+  /// @details Printing index, word, meaning, explanation, exp and level.
+  ///
+  /// @param page page number starting from 1
+  /// @param o output stream
+  /// @retval false if page is out of range
+  bool cmdList(int page, ostream* o);
+
+  /// @brief printing deck statistics as key and value lines
+  /// @details Counts come from aggregates of snapshot, due count is @n
+  ///          recounted only on the first call after midnight. @n
+  ///          Any thread may call it.
+  ///
+  /// @param o output stream
+  void cmdStats(ostream* o);
+
+  /// @brief printing query cache counts and memory accounts
+  /// @details Memory accounts are printed as "mem_" keys in bytes. @n
+  ///          They are read from writer's indexes, so it is called as a @n
+  ///          writer (under server write lock).
+  ///
+  /// @param o output stream
+  void cmdMemory(ostream* o);
+
+  /// @brief selecting next question as test does
+  /// @details Printing "question" line of word, meaning, explanation, @n
+  ///          exp and level, or "none" line if deck is empty.
+  ///
+  /// @param o output stream
+  /// @param r random generator of calling thread, NULL for engine's own
+  /// @retval true if a word is selected
+  bool cmdNext(ostream* o, Random* r);
+
+  /// @brief scoring answer of a word
+  /// @details Printing "scored" line of word, exp and level after scoring, @n
+  ///          or "none" line if there is no such word.
+  ///
+  /// @param word answered word
+  /// @param success true if answer is correct
+  /// @param o output stream
+  /// @retval true if scored
+  bool cmdScore(char* word, bool success, ostream* o);
+
+  /// @brief saving updated data without exiting
+  /// @details Printing "saved" or "unchanged" line.
+  ///
+  /// @param o output stream
+  void cmdSave(ostream* o);
+
+  /// @brief adding words of CSV/TSV records (word, meaning, explanation)
+  /// @details Header row is skipped, and records not having exactly @n
+  ///          three fields are reported as invalid. @n
+  ///          Exact duplicates are found through word hash and skipped. @n
+  ///          Similar words are found by parallel scan and still added. @n
+  ///          Both are written to report instead of asking, and whole @n
+  ///          batch is saved once. Same scan fills neighbor lists of new @n
+  ///          words and offers them to known lists of old words. Count of @n
+  ///          each outcome is written to report at last.
+  ///
+  /// @param i input stream
+  /// @param report conflict report stream
+  /// @param threads the number of scan threads, 0 for online CPUs
+  /// @retval the number of added words
+  int cmdImport(istream *i, ostream *report, int threads);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Vocabulary Test Session Class
+/// @details One test run, from the first question to the result. Questions @n
+///          are asked in a loop, not by recursion, so a session of any length @n
+///          uses same stack depth. Next questions are prefetched in a small @n
+///          fixed queue and statistics are two counters, so memory is also @n
+///          constant. Prefetched words are held out of selection until they @n
+///          are answered or the session ends.
+///
+
+class TestSession
+{
+private:
+  static const int BATCH = 8;   ///< prefetch queue size
+
+  VocaEngine *engine;           ///< engine which owns vocabulary
+  int slot[BATCH];              ///< prefetched vocabulary indexes (ring)
+  long due[BATCH];              ///< original due time of prefetched words
+  int head;                     ///< ring head position
+  int count;                    ///< the number of prefetched words
+  int correct;                  ///< correct answer counts
+  int total;                    ///< total test counts
+
+  /// @brief filling prefetch queue through engine selection
+  void prefetch(void);
+
+  /// @brief asking one question and scoring it
+  ///
+  /// @param index vocabulary index
+  void ask(int index);
+
+  /// @brief asking one multiple choice question and scoring it
+  /// @details Correct word and its distractors are shown in random order.
+  ///
+  /// @param index vocabulary index
+  void askChoice(int index);
+
+  /// @brief printing test result
+  void printResult(void);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having engine
+  ///
+  /// @param e engine whose vocabulary will be tested
+  TestSession(VocaEngine *e);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details Releasing words left in prefetch queue
+  ~TestSession(void);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief running test loop until user exits
+  ///
+  /// @param choice true for multiple choice questions
+  void run(bool choice);
+
+  /// @brief running quiz batch of distinct words
+  ///
+  /// @param n the number of questions
+  /// @param weighted true if lower level should come more often
+  void runQuiz(int n, bool weighted);
+  /// @}
 };
 
 #endif /* __VOCAMASTER__ */
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file array.h
+/// @brief Array Class Library
+/// @details Dynamic array template which complements List with constant @n
+///          time random access. Like list.h, this file is both header file @n
+///          and source file. The way to use Array is just including this file.
+///
+/// @section purpose_section Purpose
+/// Random access mirror of List for index structures
+///
+
+#ifndef __ARRAY_CLASS__
+#define __ARRAY_CLASS__
+
+#ifndef NULL
+#define NULL 0
+#endif  /* NULL */
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Dynamic Array Class with Template
+/// @details Contiguous buffer which grows twice when it is full. @n
+///          Adding to the back is amortized O(1), accessing any index is O(1) @n
+///          and removing an index shifts every later entry by one.
+///
+
+template <typename T>
+class Array
+{
+private:
+  T *data;                    ///< content buffer
+  unsigned int size;          ///< the number of used entries
+  unsigned int capacity;      ///< the number of allocated entries
+
+  /// @brief growing buffer to hold at least need entries
+  ///
+  /// @param need required capacity
+  /// @retval true if success, false if fail
+  bool grow(unsigned int need)
+  {
+    if (need <= capacity)
+      return true;
+
+    unsigned int newCap = (capacity == 0) ? 16 : capacity;
+    while (newCap < need)
+      newCap *= 2;
+
+    T *newData = new T[newCap];
+    if (!newData)
+      return false;
+
+    for (unsigned int i = 0; i < size; i++)
+      newData[i] = data[i];
+
+    if (data)
+      delete[] data;
+    data = newData;
+    capacity = newCap;
+    return true;
+  }
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  Array(void)
+  {
+    data = NULL;
+    size = 0;
+    capacity = 0;
+  }
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details As List does, contents themselves are not deleted.
+  ~Array(void)
+  {
+    if (data)
+      delete[] data;
+  }
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief return content which is contained given index
+  ///
+  /// @retval template T type, default T value if index is out of range
+  T get(unsigned int index) const
+  {
+    // index check
+    if (index >= size)
+      return T();
+
+    return data[index];
+  }
+
+  /// @brief return the number of entries which the array has
+  ///
+  /// @retval unsigned integer
+  unsigned int getSize(void) const
+  {
+    return size;
+  }
+
+  /// @brief return bytes of buffer which the array holds
+  ///
+  /// @retval allocated bytes, contents themselves are not counted
+  unsigned long getBytes(void) const
+  {
+    return (unsigned long)capacity * sizeof(T);
+  }
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief add new entry at the back
+  ///
+  /// @param content content which will be contained
+  /// @retval true if success, false if fail
+  bool add(T content)
+  {
+    if (!grow(size + 1))
+      return false;
+
+    data[size++] = content;
+    return true;
+  }
+
+  /// @brief set content to target index
+  ///
+  /// @param index entry index whose content will be set
+  /// @param content content which will be replaced
+  /// @retval true if success, false if fail
+  bool set(unsigned int index, T content)
+  {
+    // index check
+    if (index >= size)
+      return false;
+
+    data[index] = content;
+    return true;
+  }
+
+  /// @brief remove target index, shifting later entries forward
+  ///
+  /// @param index entry index which will be removed
+  /// @retval true if success, false if fail
+  bool remove(unsigned int index)
+  {
+    // index check
+    if (index >= size)
+      return false;
+
+    for (unsigned int i = index + 1; i < size; i++)
+      data[i - 1] = data[i];
+    size--;
+    return true;
+  }
+
+  /// @brief remove every entry, keeping the buffer for reuse
+  void clear(void)
+  {
+    size = 0;
+  }
+
+  /// @brief sort entries by stable merge sort, O(n log n)
+  ///
+  /// @param cmp comparison which is negative, zero or positive @n
+  ///            as first argument is lower, equal or higher
+  void sort(int (*cmp)(T, T))
+  {
+    if (size < 2)
+      return;
+
+    T *base = data;
+    T *tmp = new T[size];
+    for (unsigned int width = 1; width < size; width *= 2) {
+      // merge each two adjacent runs of width into tmp
+      for (unsigned int lo = 0; lo < size; lo += 2 * width) {
+        unsigned int mid = (lo + width < size) ? lo + width : size;
+        unsigned int hi = (lo + 2 * width < size) ? lo + 2 * width : size;
+        unsigned int i = lo, j = mid, k = lo;
+
+        while (i < mid && j < hi)
+          tmp[k++] = (cmp(data[j], data[i]) < 0) ? data[j++] : data[i++];
+        while (i < mid)
+          tmp[k++] = data[i++];
+        while (j < hi)
+          tmp[k++] = data[j++];
+      }
+
+      T *swap = data;
+      data = tmp;
+      tmp = swap;
+    }
+
+    // result ends in buffer of size entries after odd passes
+    if (data != base) {
+      for (unsigned int i = 0; i < size; i++)
+        base[i] = data[i];
+      tmp = data;
+      data = base;
+    }
+    delete[] tmp;
+  }
+  /// @}
+};
+
+#endif  /* __ARRAY_CLASS__ */
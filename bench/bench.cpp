@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file bench.cpp
+/// @brief Benchmark Source File
+/// @details Timing engine operations over synthetic decks
+///
+/// @section purpose_section Purpose
+/// Comparing performance between commits
+///
+/// @section usage_section Usage
+/// vocaBench gen NUMBER FILE [--seed NUMBER] @n
+/// vocaBench run FILE @n
+/// vocaBench suite DIR NUMBER... @n
+/// run prints one JSON object per deck, suite prints {"format", "runs"} @n
+/// with each deck measured in its own process, so peak RSS is per deck.
+///
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "VocaMaster.h"
+#include "strutil.h"
+#include "deckfile.h"
+#include "deckgen.h"
+
+#define FORMAT        1         ///< version of JSON layout
+#define SEED          20150301  ///< default generator seed
+#define SELECT_OPS    200000    ///< selectVoca calls
+#define PAGE_OPS      10000     ///< pages read per view
+#define SCAN_WORK     2000000   ///< words scanned by findSim benchmark
+#define LIST_PAGE     10        ///< entries per page, same as list menu
+
+using namespace std;
+
+/// @brief monotonic clock in seconds
+static double seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// @brief clamping v into [lo, hi]
+static unsigned long clamp(unsigned long v, unsigned long lo, unsigned long hi) {
+  return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Benchmark Class
+/// @details Friend of VocaEngine, so private operations are timed without @n
+///          console I/O. Each result has ops, ns_per_op and mb_per_s, which @n
+///          is 0 when operation reads no data.
+///
+
+class Benchmark
+{
+private:
+  ostream *out;                 ///< JSON output
+  bool first;                   ///< true until first result is written
+
+  /// @brief writing one result
+  ///
+  /// @param name result name
+  /// @param ops the number of operations
+  /// @param elapsed seconds
+  /// @param bytes bytes processed, 0 if none
+  void report(const char* name, unsigned long ops, double elapsed,
+              double bytes);
+
+public:
+  /// @brief constructor having output stream
+  Benchmark(ostream* o) : out(o), first(true) {}
+
+  /// @brief measuring every operation over deck file
+  ///
+  /// @param file data file
+  void run(char* file);
+};
+
+void Benchmark::report(const char* name, unsigned long ops, double elapsed,
+                       double bytes)
+{
+  char line[256];
+  double ns = (ops > 0) ? elapsed * 1e9 / ops : 0;
+  double mbs = (bytes > 0 && elapsed > 0) ? bytes / elapsed / 1e6 : 0;
+
+  snprintf(line, sizeof(line),
+           "%s\n    {\"name\": \"%s\", \"ops\": %lu, \"ns_per_op\": %.1f, "
+           "\"mb_per_s\": %.2f}", first ? "" : ",", name, ops, ns, mbs);
+  *out << line;
+  first = false;
+}
+
+void Benchmark::run(char* file)
+{
+  struct stat st;
+  if (stat(file, &st) != 0) {
+    cout << "error\tcannot open\t" << file << endl;
+    return;
+  }
+  double bytes = (double)st.st_size;
+
+  double t = seconds();
+  VocaEngine *engine = new VocaEngine(file, true);
+  double loadTime = seconds() - t;
+  unsigned long n = engine->table->getSize();
+
+  *out << "{\"deck\": \"" << file << "\", \"entries\": " << n
+       << ", \"bytes\": " << st.st_size << ", \"results\": [";
+  first = true;
+  report("load", n, loadTime, bytes);
+
+  // save rewrites whole file
+  engine->dirty = true;
+  t = seconds();
+  engine->saveChange();
+  report("save", n, seconds() - t, bytes);
+
+  if (n > 0) {
+    // queries are deck words with one more letter, so nothing is equal
+    unsigned long queries = clamp(SCAN_WORK / n, 3, 200);
+    char query[DeckReader::FIELD_SIZE + 2];
+    double scanned = 0, wordBytes = 0;
+    for (unsigned long k = 0; k < n; k++)
+      wordBytes += Strlen(engine->table->get(k)->getWord());
+    t = seconds();
+    for (unsigned long q = 0; q < queries; q++) {
+      Voca *voca = engine->table->get((q * 7919) % n);
+      Strcpy(query, voca->getWord());
+      Strcpy(query + Strlen(query), (char*)"x");
+
+      Array <int> similar, score;
+      engine->scanAll(query, &similar, &score);
+      scanned += n;
+    }
+    double elapsed = seconds() - t;
+    report("findSim", queries, elapsed, queries * wordBytes);
+    report("findSim_word", (unsigned long)scanned, elapsed, 0);
+
+    // same query again, answered by query cache
+    Array <int> similar, score;
+    engine->scanSim(query, &similar, &score);
+    t = seconds();
+    for (unsigned long q = 0; q < SELECT_OPS; q++) {
+      similar.clear();
+      score.clear();
+      engine->scanSim(query, &similar, &score);
+    }
+    report("findSim_cached", SELECT_OPS, seconds() - t, 0);
+  }
+
+  t = seconds();
+  int sink = 0;
+  for (unsigned long k = 0; k < SELECT_OPS; k++)
+    sink += engine->selectVoca();
+  report("selectVoca", SELECT_OPS, seconds() - t, 0);
+
+  // every view, pages at spread out positions as manageList shows them
+  const char *viewName[] = { "page_inserted", "page_word", "page_level",
+                             "page_exp", "page_weak" };
+  unsigned int pages = (n + LIST_PAGE - 1) / LIST_PAGE;
+  for (int v = 0; v < VocaEngine::VIEWS && pages > 0; v++) {
+    t = seconds();
+    unsigned long read = 0;
+    for (unsigned long p = 0; p < PAGE_OPS; p++) {
+      unsigned int start = ((p * 104729) % pages) * LIST_PAGE;
+      for (unsigned int k = start; k < start + LIST_PAGE && k < n; k++) {
+        if (engine->viewGet(v, k))
+          read++;
+      }
+    }
+    report(viewName[v], PAGE_OPS, seconds() - t, 0);
+    sink += (int)read;
+  }
+
+  delete(engine);
+
+  // List<T> itself: append, indexed walk, delete from front
+  char payload[256];
+  List <char*> list;
+  t = seconds();
+  for (unsigned long k = 0; k < n; k++)
+    list.addNode(payload + (k & 255));
+  report("list_add", n, seconds() - t, 0);
+
+  unsigned long gets = clamp(20000000 / (n + 1), 10, 10000);
+  t = seconds();
+  for (unsigned long k = 0; k < gets && n > 0; k++)
+    sink += (int)(list.getContent((unsigned int)((k * 7919) % n)) - payload);
+  report("list_get", gets, seconds() - t, 0);
+
+  t = seconds();
+  while (list.getSize() > 0)
+    list.delNode(0);
+  report("list_del", n, seconds() - t, 0);
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  *out << "\n  ], \"peak_rss_bytes\": " << (long)usage.ru_maxrss * 1024
+       << ", \"checksum\": " << (sink & 1) << "}";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief main function
+///
+
+static void usage(char* name) {
+  cout << "usage : " << name << " gen NUMBER FILE [--seed NUMBER]" << endl;
+  cout << "        " << name << " run FILE" << endl;
+  cout << "        " << name << " suite DIR NUMBER..." << endl;
+}
+
+/// @brief generating deck file
+static bool generate(char* file, unsigned long n, unsigned long long seed) {
+  ofstream o(file);
+  if (!o.good()) {
+    cout << "error\tcannot open\t" << file << endl;
+    return false;
+  }
+
+  DeckGenerator gen(seed);
+  gen.write(&o, n);
+  o.close();
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if (argc >= 4 && Strequal(argv[1], (char*)"gen")) {
+    unsigned long long seed = SEED;
+    if (argc == 6 && Strequal(argv[4], (char*)"--seed"))
+      seed = StrToInt(argv[5]);
+    else if (argc != 4) {
+      usage(argv[0]);
+      return 1;
+    }
+    return generate(argv[3], StrToInt(argv[2]), seed) ? 0 : 2;
+  }
+
+  if (argc == 3 && Strequal(argv[1], (char*)"run")) {
+    Benchmark bench(&cout);
+    bench.run(argv[2]);
+    cout << endl;
+    return 0;
+  }
+
+  if (argc >= 4 && Strequal(argv[1], (char*)"suite")) {
+    char *dir = argv[2];
+    mkdir(dir, 0755);
+
+    cout << "{\"format\": " << FORMAT << ", \"runs\": [" << endl;
+    for (int k = 3; k < argc; k++) {
+      unsigned long n = StrToInt(argv[k]);
+      char name[64];
+      snprintf(name, sizeof(name), "/deck-%lu.dat", n);
+      char *file = Strjoin(dir, name);
+
+      // same seed makes same deck, so existing one is reused
+      struct stat st;
+      if (stat(file, &st) != 0 && !generate(file, n, SEED))
+        return 2;
+
+      cout.flush();
+      pid_t pid = fork();
+      if (pid < 0) {
+        cout << "error\tcannot fork" << endl;
+        return 2;
+      }
+      if (pid == 0) { // own process, own peak RSS
+        Benchmark bench(&cout);
+        bench.run(file);
+        cout << ((k + 1 < argc) ? "," : "") << endl;
+        cout.flush();
+        _exit(0);
+      }
+      int status;
+      waitpid(pid, &status, 0);
+      delete[] file;
+    }
+    cout << "]}" << endl;
+    return 0;
+  }
+
+  usage(argv[0]);
+  return 1;
+}
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file deckgen.cpp
+/// @brief Deck Generator Source File
+/// @details Synthetic data files for benchmarks
+///
+/// @section purpose_section Purpose
+/// Making decks of any size which look like shipped voca.dat
+///
+
+#include <ctime>
+#include "deckgen.h"
+#include "deckfile.h"
+#include "strutil.h"
+
+#define HIRAGANA      0x3041
+#define HIRAGANA_N    83
+#define KATAKANA      0x30A1
+#define KATAKANA_N    90
+#define KANJI         0x4E00
+#define KANJI_N       2000  ///< common ones are near the start of block
+#define HANGUL        0xAC00
+#define HANGUL_N      11172
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckGenerator class functions implementation
+///
+
+DeckGenerator::DeckGenerator(unsigned long long seed) : random(seed)
+{
+}
+
+void DeckGenerator::putCode(char* buf, int &len, unsigned int code)
+{
+  if (code < 0x80) {
+    buf[len++] = (char)code;
+  } else if (code < 0x800) {
+    buf[len++] = (char)(0xC0 | (code >> 6));
+    buf[len++] = (char)(0x80 | (code & 0x3F));
+  } else {
+    buf[len++] = (char)(0xE0 | (code >> 12));
+    buf[len++] = (char)(0x80 | ((code >> 6) & 0x3F));
+    buf[len++] = (char)(0x80 | (code & 0x3F));
+  }
+  buf[len] = '\0';
+}
+
+void DeckGenerator::putRun(char* buf, int &len, unsigned int first,
+                           unsigned int count, int n)
+{
+  for (int k = 0; k < n; k++)
+    putCode(buf, len, first + (unsigned int)random.below(count));
+}
+
+void DeckGenerator::write(ostream* o, unsigned long n)
+{
+  DeckWriter writer(o);
+  long now = (long)time(0);
+  char word[64], mean[64], explain[64];
+
+  for (unsigned long k = 0; k < n; k++) {
+    int wl = 0, ml = 0, el = 0;
+    word[0] = mean[0] = explain[0] = '\0';
+
+    // same mix as voca.dat, mostly Kanji, then Kana, some ASCII
+    int kind = (int)random.below(20);
+    const char *tag;
+    if (kind < 11) {
+      putRun(word, wl, KANJI, KANJI_N, 1 + (int)random.below(2));
+      putRun(word, wl, HIRAGANA, HIRAGANA_N, (int)random.below(3));
+      putRun(explain, el, HIRAGANA, HIRAGANA_N, 2 + (int)random.below(4));
+      tag = "(한자)";
+    } else if (kind < 15) {
+      putRun(word, wl, KATAKANA, KATAKANA_N, 2 + (int)random.below(4));
+      putRun(explain, el, HIRAGANA, HIRAGANA_N, 2 + (int)random.below(4));
+      tag = "(카타카나)";
+    } else if (kind < 17) {
+      putRun(word, wl, HIRAGANA, HIRAGANA_N, 2 + (int)random.below(4));
+      putRun(explain, el, HIRAGANA, HIRAGANA_N, 2 + (int)random.below(4));
+      tag = "(히라가나)";
+    } else {
+      putRun(word, wl, 'a', 26, 3 + (int)random.below(8));
+      putRun(explain, el, 'a', 26, 3 + (int)random.below(8));
+      tag = "(영어)";
+    }
+    putRun(mean, ml, HANGUL, HANGUL_N, 1 + (int)random.below(5));
+    Strcpy(mean + ml, (char*)tag);
+
+    int level = 1 + (int)random.below(5);
+    int exp = 10 * (int)random.below(10);
+    int interval = (int)random.below(65);
+    long due = now + (long)random.below(30 * 86400) - 7 * 86400;
+
+    writer.write(word, mean, explain, exp, level, due, interval);
+  }
+}
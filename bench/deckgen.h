@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file deckgen.h
+/// @brief Deck Generator Header File
+/// @details Synthetic data files for benchmarks
+///
+/// @section purpose_section Purpose
+/// Making decks of any size which look like shipped voca.dat
+///
+
+#ifndef __DECKGEN__
+#define __DECKGEN__
+
+#include <iostream>
+#include "sampler.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Deck Generator Class
+/// @details Words are Kanji with Hiragana ending, Katakana or ASCII, @n
+///          meanings are Hangul with a tag like "(한자)", explanations are @n
+///          Hiragana readings, as in voca.dat. Scores and review times are @n
+///          spread over every level. Same seed makes same deck.
+///
+
+class DeckGenerator
+{
+private:
+  Random random;                ///< generator of every field
+
+  /// @brief appending UTF-8 encoding of code point
+  ///
+  /// @param buf target buffer
+  /// @param len current length, advanced
+  /// @param code Unicode code point
+  static void putCode(char* buf, int &len, unsigned int code);
+
+  /// @brief appending characters drawn from code point range
+  ///
+  /// @param buf target buffer
+  /// @param len current length, advanced
+  /// @param first first code point of range
+  /// @param count the number of code points in range
+  /// @param n the number of characters
+  void putRun(char* buf, int &len, unsigned int first, unsigned int count,
+              int n);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having seed
+  ///
+  /// @param seed random seed
+  DeckGenerator(unsigned long long seed);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief writing deck in data file format
+  ///
+  /// @param o output stream
+  /// @param n the number of records
+  void write(ostream* o, unsigned long n);
+  /// @}
+};
+
+#endif /* __DECKGEN__ */
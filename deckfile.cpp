@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file deckfile.cpp
+/// @brief Data File Source File
+/// @details Streaming reader and writer of vocabulary data file
+///
+/// @section purpose_section Purpose
+/// Sharing data file format among engine and deck tools
+///
+
+#include <fstream>
+#include "deckfile.h"
+#include "strutil.h"
+#include "probe.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckReader class functions implementation
+///
+
+DeckReader::DeckReader(istream *i) : in(i), exp(0), level(1), due(0),
+  interval(0), offset(0), start(0)
+{
+  word[0] = '\0';
+  mean[0] = '\0';
+  explain[0] = '\0';
+}
+
+bool DeckReader::readField(char* buf)
+{
+  int index = 0;
+  while (in->peek() != '%' && in->peek() != '$' && !in->eof() && !in->bad()) {
+    if (index >= FIELD_SIZE - 1)
+      return false;
+    buf[index++] = in->get();
+  }
+  buf[index] = '\0';
+  offset += index;
+
+  return true;
+}
+
+char* DeckReader::getWord(void)
+{
+  return word;
+}
+
+char* DeckReader::getMean(void)
+{
+  return mean;
+}
+
+char* DeckReader::getExplain(void)
+{
+  return explain;
+}
+
+int DeckReader::getExp(void) const
+{
+  return exp;
+}
+
+int DeckReader::getLevel(void) const
+{
+  return level;
+}
+
+long DeckReader::getDue(void) const
+{
+  return due;
+}
+
+int DeckReader::getInterval(void) const
+{
+  return interval;
+}
+
+unsigned long long DeckReader::getOffset(void) const
+{
+  return start;
+}
+
+int DeckReader::next(void)
+{
+  while (isWhite(in->peek())) {
+    in->get(); // consume white space
+    offset++;
+  }
+
+  if (in->eof() || in->bad() || in->peek() == -1)
+    return 0;
+
+  start = offset;
+
+  char buf[FIELD_SIZE];
+  char *field[4] = { word, mean, explain, buf };
+
+  // word, meaning, explanation and exp end with '%'
+  for (int f = 0; f < 4; f++) {
+    if (!readField(field[f]) || in->peek() != '%')
+      return -1;
+    in->get(); // consume token
+    offset++;
+  }
+  exp = StrToInt(buf);
+
+  // get level
+  if (!readField(buf))
+    return -1;
+  level = StrToInt(buf);
+
+  due = 0;
+  interval = 0;
+  if (in->peek() == '%') { // schedule fields, absent in older data file
+    in->get(); // consume token
+    offset++;
+
+    if (!readField(buf) || in->peek() != '%')
+      return -1;
+    due = StrToInt(buf);
+    in->get(); // consume token
+    offset++;
+
+    if (!readField(buf))
+      return -1;
+    interval = StrToInt(buf);
+  }
+
+  if (in->peek() != '$')
+    return -1;
+  in->get(); // consume token
+  offset++;
+  PROBE_COUNT(BYTES, offset - start);
+
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckWriter class functions implementation
+///
+
+DeckWriter::DeckWriter(ostream *o) : out(o)
+{
+}
+
+void DeckWriter::writeField(char* str, char delim)
+{
+  int pnt = 0;
+  while (str[pnt] != '\0')
+    out->put(str[pnt++]);
+  out->put(delim);
+}
+
+void DeckWriter::writeNumber(long num, char delim)
+{
+  char *str = IntToStr(num);
+  writeField(str, delim);
+  delete[] str;
+}
+
+void DeckWriter::write(char* w, char* m, char* e, int x, int l, long d, int v)
+{
+  writeField(w, '%');
+  writeField(m, '%');
+  writeField(e, '%');
+  writeNumber(x, '%');
+  writeNumber(l, '%');
+  writeNumber(d, '%');
+  writeNumber(v, '$');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckShards class functions implementation
+///
+
+char* DeckShards::name(char* file, unsigned int k, unsigned int count)
+{
+  if (count == 1)
+    return Strjoin(file, (char*)"");
+
+  char *number = IntToStr(k);
+  char *dot = Strjoin(file, (char*)".");
+  char *name = Strjoin(dot, number);
+  delete[] number;
+  delete[] dot;
+  return name;
+}
+
+unsigned int DeckShards::count(char* file)
+{
+  unsigned int count = 0;   // length of sequence from shard 0
+  unsigned int found = 0;   // every shard file
+  for (unsigned int k = 0; k < MAX; k++) {
+    char *shard = name(file, k, 2);
+    ifstream in(shard);
+    delete[] shard;
+    if (in.good() && ++found == k + 1)
+      count = k + 1;
+  }
+
+  if (found != count || count == 1)
+    return 0; // part of deck is missing
+  return (count > 1) ? count : 1;
+}
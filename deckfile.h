@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file deckfile.h
+/// @brief Data File Header File
+/// @details Streaming reader and writer of vocabulary data file. @n
+///          Each record is "word%meaning%explain%exp%level%due%interval$", @n
+///          and older records without due and interval are also accepted.
+///
+/// @section purpose_section Purpose
+/// Sharing data file format among engine and deck tools
+///
+
+#ifndef __DECKFILE__
+#define __DECKFILE__
+
+#include <iostream>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Data File Reader Class
+/// @details Reading one record at a time, so whole file never needs to be @n
+///          in memory. Field strings are valid until next record is read.
+///
+
+class DeckReader
+{
+public:
+  static const int FIELD_SIZE = 100;  ///< maximum field length + 1
+
+private:
+  istream *in;                  ///< input stream (not owned)
+  char word[FIELD_SIZE];        ///< word of current record
+  char mean[FIELD_SIZE];        ///< meaning of current record
+  char explain[FIELD_SIZE];     ///< explanation of current record
+  int exp;                      ///< exp of current record
+  int level;                    ///< level of current record
+  long due;                     ///< due time of current record
+  int interval;                 ///< review interval of current record
+  unsigned long long offset;    ///< byte offset of next unread character
+  unsigned long long start;     ///< byte offset of current record
+
+  /// @brief reading one field until '%' or '$'
+  ///
+  /// @param buf buffer of FIELD_SIZE characters
+  /// @retval true if success, false if field is too long
+  bool readField(char* buf);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having input stream
+  ///
+  /// @param i input stream
+  DeckReader(istream *i);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting word of current record
+  char* getWord(void);
+
+  /// @brief getting meaning of current record
+  char* getMean(void);
+
+  /// @brief getting explanation of current record
+  char* getExplain(void);
+
+  /// @brief getting exp of current record
+  int getExp(void) const;
+
+  /// @brief getting level of current record
+  int getLevel(void) const;
+
+  /// @brief getting due time of current record
+  long getDue(void) const;
+
+  /// @brief getting review interval of current record
+  int getInterval(void) const;
+
+  /// @brief getting byte offset where current record starts
+  unsigned long long getOffset(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief reading next record
+  ///
+  /// @retval 1 if record is read
+  /// @retval 0 at end of input
+  /// @retval -1 if data file is broken
+  int next(void);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Data File Writer Class
+/// @details Writing records in the format DeckReader reads.
+///
+
+class DeckWriter
+{
+private:
+  ostream *out;                 ///< output stream (not owned)
+
+  /// @brief writing one field followed by delimiter
+  void writeField(char* str, char delim);
+
+  /// @brief writing one number field followed by delimiter
+  void writeNumber(long num, char delim);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having output stream
+  ///
+  /// @param o output stream
+  DeckWriter(ostream *o);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief writing one record
+  ///
+  /// @param w word string
+  /// @param m meaning string
+  /// @param e explanation string
+  /// @param x experience score
+  /// @param l level point
+  /// @param d next review time
+  /// @param v review interval in days
+  void write(char* w, char* m, char* e, int x, int l, long d, int v);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Data File Shards Class
+/// @details A deck is one data file, or shard files "file.0" to @n
+///          "file.n-1" of at least two shards, which are always written @n
+///          as a whole sequence. Engine and deck tools find shards here.
+///
+
+class DeckShards
+{
+public:
+  static const unsigned int MAX = 256;  ///< most shard files of one deck
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting file name of shard
+  /// @details Single shard is data file itself, otherwise shard k is @n
+  ///          data file name followed by ".k".
+  ///
+  /// @param file data file name
+  /// @param k shard number
+  /// @param count the number of shards
+  /// @retval new file name
+  static char* name(char* file, unsigned int k, unsigned int count);
+
+  /// @brief counting shard files on disk
+  ///
+  /// @param file data file name
+  /// @retval the number of shard files, 1 if there is none
+  /// @retval 0 if sequence has a gap or only "file.0" exists
+  static unsigned int count(char* file);
+  /// @}
+};
+
+#endif /* __DECKFILE__ */
@@ -0,0 +1,357 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file dict.cpp
+/// @brief Word Dictionary Source File
+/// @details Front coded sorted words with restart points
+///
+/// @section purpose_section Purpose
+/// Exact lookup and sorted walk of a read-mostly deck in little memory
+///
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "dict.h"
+#include "strutil.h"
+
+#define VARINT_MAX    5 ///< bytes of largest 32-bit varint
+#define DICT_MAGIC    "VMDICT1" ///< file format tag, with terminating zero
+
+/// @brief header of dictionary file, block heads and buffer follow it
+struct DictHeader
+{
+  char magic[8];                ///< DICT_MAGIC
+  unsigned long long stamp;     ///< content hash of vocabulary list
+  unsigned int slots;           ///< the number of list slots
+  unsigned int size;            ///< the number of words
+  unsigned int blocks;          ///< the number of block heads
+  unsigned int used;            ///< bytes of buffer
+  unsigned int longest;         ///< length of longest word
+  unsigned int reserved;        ///< zero, keeps header size a multiple of 8
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief WordDict class functions implementation
+///
+
+WordDict::WordDict(void) : data(NULL), used(0), capacity(0), size(0),
+  last(NULL), room(0), mapping(NULL), mapLength(0)
+{
+  reserve(64);
+}
+
+WordDict::~WordDict(void)
+{
+  if (mapping)
+    unmap();
+  if (data)
+    delete[] data;
+  if (last)
+    delete[] last;
+}
+
+void WordDict::unmap(void)
+{
+  munmap(mapping, mapLength);
+  mapping = NULL;
+  mapLength = 0;
+  data = NULL;
+  used = 0;
+  size = 0;
+  restart.clear();
+}
+
+bool WordDict::grow(unsigned int need)
+{
+  if (need <= capacity)
+    return true;
+
+  unsigned int newCap = (capacity == 0) ? 4096 : capacity;
+  while (newCap < need)
+    newCap *= 2;
+
+  unsigned char *newData = new unsigned char[newCap];
+  if (!newData)
+    return false;
+
+  for (unsigned int i = 0; i < used; i++)
+    newData[i] = data[i];
+
+  if (data)
+    delete[] data;
+  data = newData;
+  capacity = newCap;
+  return true;
+}
+
+bool WordDict::reserve(unsigned int need)
+{
+  if (need <= room)
+    return true;
+
+  unsigned int newRoom = (room == 0) ? 64 : room;
+  while (newRoom < need)
+    newRoom *= 2;
+
+  char *newLast = new char[newRoom];
+  if (!newLast)
+    return false;
+
+  for (unsigned int i = 0; i < room; i++)
+    newLast[i] = last[i];
+  if (room == 0)
+    newLast[0] = '\0';
+
+  if (last)
+    delete[] last;
+  last = newLast;
+  room = newRoom;
+  return true;
+}
+
+void WordDict::putVarint(unsigned int v)
+{
+  while (v >= 0x80) {
+    data[used++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  data[used++] = (unsigned char)v;
+}
+
+unsigned int WordDict::getVarint(const unsigned char* &p)
+{
+  unsigned int v = 0;
+  for (int shift = 0; ; shift += 7) {
+    unsigned char b = *p++;
+    v |= (unsigned int)(b & 0x7F) << shift;
+    if (b < 0x80)
+      return v;
+  }
+}
+
+bool WordDict::getVarint(const unsigned char* &p, const unsigned char* end,
+                         unsigned int &v)
+{
+  v = 0;
+  for (int shift = 0; shift < 7 * VARINT_MAX && p < end; shift += 7) {
+    unsigned char b = *p++;
+    v |= (unsigned int)(b & 0x7F) << shift;
+    if (b < 0x80)
+      return true;
+  }
+  return false;
+}
+
+bool WordDict::check(unsigned int longest, unsigned int slots)
+{
+  const unsigned char *p = data;
+  const unsigned char *end = data + used;
+  unsigned int previous = 0; // length of previous word
+
+  for (unsigned int rank = 0; rank < size; rank++) {
+    unsigned int shared, length, id;
+    if (rank % BLOCK == 0 && p != data + restart.get(rank / BLOCK))
+      return false;
+    if (!getVarint(p, end, shared) || !getVarint(p, end, length))
+      return false;
+
+    // previous word fits in longest, so no subtraction wraps
+    if (shared > previous || (rank % BLOCK == 0 && shared != 0) ||
+        length > longest - shared || length > (unsigned int)(end - p))
+      return false;
+    p += length;
+
+    if (!getVarint(p, end, id) || id >= slots)
+      return false;
+    previous = shared + length;
+  }
+
+  return p == end;
+}
+
+int WordDict::decode(const unsigned char* &p)
+{
+  unsigned int shared = getVarint(p);
+  unsigned int length = getVarint(p);
+
+  // buffer holds the longest word already, it was reserved by add
+  for (unsigned int i = 0; i < length; i++)
+    last[shared + i] = (char)*p++;
+  last[shared + length] = '\0';
+
+  return (int)getVarint(p);
+}
+
+unsigned int WordDict::getSize(void) const
+{
+  return size;
+}
+
+unsigned long WordDict::getBytes(void) const
+{
+  return (mapping ? mapLength : capacity) + restart.getBytes() + room;
+}
+
+bool WordDict::isMapped(void) const
+{
+  return mapping != NULL;
+}
+
+bool WordDict::add(char* word, int id)
+{
+  unsigned int length = Strlen(word);
+  unsigned int shared = 0;
+
+  if (mapping) // words are added to a buffer of its own
+    unmap();
+
+  if (size % BLOCK == 0) { // restart point keeps whole word
+    if (!restart.add(used))
+      return false;
+  } else {
+    while (shared < length && last[shared] == word[shared])
+      shared++;
+  }
+
+  if (!grow(used + 3 * VARINT_MAX + length - shared) || !reserve(length + 1))
+    return false;
+
+  putVarint(shared);
+  putVarint(length - shared);
+  for (unsigned int i = shared; i < length; i++)
+    data[used++] = (unsigned char)word[i];
+  putVarint((unsigned int)id);
+
+  Strcpy(last, word);
+  size++;
+  return true;
+}
+
+void WordDict::clear(void)
+{
+  if (mapping)
+    unmap();
+  used = 0;
+  size = 0;
+  restart.clear();
+  last[0] = '\0';
+}
+
+int WordDict::find(char* word)
+{
+  if (size == 0)
+    return -1;
+
+  // last block whose head is lower, same word may begin in previous block
+  unsigned int lo = 0, hi = restart.getSize();
+  while (hi - lo > 1) {
+    unsigned int mid = (lo + hi) / 2;
+    const unsigned char *p = data + restart.get(mid);
+    decode(p);
+    if (Strcmp(last, word) < 0)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  const unsigned char *p = data + restart.get(lo);
+  for (unsigned int rank = lo * BLOCK; rank < size; rank++) {
+    int id = decode(p);
+    int cmp = Strcmp(last, word);
+    if (cmp == 0)
+      return id;
+    if (cmp > 0)
+      break;
+  }
+
+  return -1;
+}
+
+int WordDict::get(unsigned int rank)
+{
+  if (rank >= size)
+    return -1;
+
+  const unsigned char *p = data + restart.get(rank / BLOCK);
+  int id = decode(p);
+  for (unsigned int k = rank % BLOCK; k > 0; k--)
+    id = decode(p);
+
+  return id;
+}
+
+bool WordDict::map(char* file, unsigned long long stamp, unsigned int slots)
+{
+  clear();
+
+  int fd = open(file, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (unsigned long)st.st_size >= sizeof(DictHeader))
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // mapping stays valid
+  if (base == MAP_FAILED)
+    return false;
+
+  DictHeader *header = (DictHeader*)base;
+  const unsigned int *heads = (const unsigned int*)(header + 1);
+  unsigned long length = (unsigned long)st.st_size;
+  bool good = Strequal((char*)DICT_MAGIC, header->magic) &&
+    header->stamp == stamp && header->slots == slots &&
+    header->blocks == (header->size + BLOCK - 1) / BLOCK &&
+    length == sizeof(DictHeader) + header->blocks * sizeof(unsigned int)
+              + header->used &&
+    header->longest <= header->used && reserve(header->longest + 1);
+
+  // heads are read once here, buffer is decoded in place
+  for (unsigned int b = 0; good && b < header->blocks; b++) {
+    good = heads[b] < header->used && (b == 0 || heads[b] > heads[b - 1]) &&
+      restart.add(heads[b]);
+  }
+  if (!good) {
+    restart.clear();
+    munmap(base, length);
+    return false;
+  }
+
+  if (data)
+    delete[] data;
+  capacity = 0;
+  mapping = base;
+  mapLength = length;
+  data = (unsigned char*)(heads + header->blocks);
+  used = header->used;
+  size = header->size;
+  if (!check(header->longest, slots)) { // decode trusts lengths and ids
+    unmap();
+    return false;
+  }
+  return true;
+}
+
+void WordDict::save(ostream* o, unsigned long long stamp, unsigned int slots)
+{
+  DictHeader header;
+  for (unsigned int c = 0; c < sizeof(header.magic); c++)
+    header.magic[c] = '\0';
+  Strcpy(header.magic, (char*)DICT_MAGIC);
+  header.stamp = stamp;
+  header.slots = slots;
+  header.size = size;
+  header.blocks = restart.getSize();
+  header.used = used;
+  header.longest = room - 1; // decoding buffer fits every word
+  header.reserved = 0;
+  o->write((const char*)&header, sizeof(header));
+
+  for (unsigned int b = 0; b < restart.getSize(); b++) {
+    unsigned int head = restart.get(b);
+    o->write((const char*)&head, sizeof(head));
+  }
+  o->write((const char*)data, used);
+}
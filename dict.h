@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file dict.h
+/// @brief Word Dictionary Header File
+/// @details Front coded sorted words with restart points
+///
+/// @section purpose_section Purpose
+/// Exact lookup and sorted walk of a read-mostly deck in little memory
+///
+
+#ifndef __DICT__
+#define __DICT__
+
+#include <iostream>
+#include "array.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Word Dictionary Class
+/// @details Words are appended in byte order and packed into one buffer. @n
+///          Every BLOCK words a restart point stores whole word, and each @n
+///          later word stores only the length of prefix it shares with @n
+///          previous word, its own suffix, and its id. Lengths and ids are @n
+///          varints. Lookup is binary search over restart points, then @n
+///          decoding at most a few blocks, so O(log n + BLOCK). @n
+///          Owner clears it and adds every word again when word set @n
+///          changes, and looks words up only after the last add. @n
+///          Saved file is block heads and buffer as they are in memory, @n
+///          so a matching file is mapped and read in place.
+///
+
+class WordDict
+{
+public:
+  static const int BLOCK = 16;  ///< words per restart point
+
+private:
+  unsigned char *data;          ///< encoded words
+  unsigned int used;            ///< bytes used in data
+  unsigned int capacity;        ///< bytes allocated for data
+  Array <unsigned int> restart; ///< offset of each block head
+  unsigned int size;            ///< the number of words
+  char *last;                   ///< previous word while adding, decoding buffer
+  unsigned int room;            ///< bytes allocated for last
+  void *mapping;                ///< mapped file which data points into, or NULL
+  unsigned long mapLength;      ///< bytes of mapping
+
+  /// @brief unmapping file, leaving dictionary empty
+  void unmap(void);
+
+  /// @brief growing data to hold at least need bytes
+  ///
+  /// @param need required capacity
+  /// @retval true if success, false if fail
+  bool grow(unsigned int need);
+
+  /// @brief growing word buffer to hold at least need bytes
+  ///
+  /// @param need required capacity
+  /// @retval true if success, false if fail
+  bool reserve(unsigned int need);
+
+  /// @brief appending varint to data, which has room for it
+  void putVarint(unsigned int v);
+
+  /// @brief reading varint, advancing position
+  static unsigned int getVarint(const unsigned char* &p);
+
+  /// @brief reading varint which must end before end, advancing position
+  ///
+  /// @param p position of varint
+  /// @param end end of buffer
+  /// @param v receiving value
+  /// @retval true if success, false if it runs past end or 32 bits
+  static bool getVarint(const unsigned char* &p, const unsigned char* end,
+                        unsigned int &v);
+
+  /// @brief checking every entry of mapped buffer before it is decoded
+  /// @details Block heads must be where blocks begin, words must fit in @n
+  ///          longest bytes and buffer, and ids must be lower than slots.
+  ///
+  /// @param longest length of longest word
+  /// @param slots the number of list slots
+  /// @retval true if every entry is good
+  bool check(unsigned int longest, unsigned int slots);
+
+  /// @brief decoding one word into last, advancing position
+  ///
+  /// @param p position of entry
+  /// @retval id of word
+  int decode(const unsigned char* &p);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  WordDict(void);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~WordDict(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of words
+  unsigned int getSize(void) const;
+
+  /// @brief getting bytes of buffers
+  ///
+  /// @retval allocated or mapped bytes
+  unsigned long getBytes(void) const;
+
+  /// @brief checking whether words are read from mapped file
+  bool isMapped(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief appending word, which is not lower than previous one
+  ///
+  /// @param word word string
+  /// @param id value of word, such as list index
+  /// @retval true if success, false if fail
+  bool add(char* word, int id);
+
+  /// @brief removing every word, keeping buffers for reuse
+  void clear(void);
+
+  /// @brief finding exactly same word
+  /// @details If same word was added more than once, first one is found.
+  ///
+  /// @param word target word
+  /// @retval id, -1 if there is none
+  int find(char* word);
+
+  /// @brief getting word of rank in byte order
+  ///
+  /// @param rank 0 for lowest word
+  /// @retval id, -1 if rank is out of range
+  int get(unsigned int rank);
+
+  /// @brief mapping saved dictionary file in place of current words
+  /// @details File is accepted only if it was saved with same stamp and @n
+  ///          same slot count, and every entry decodes inside the file, @n
+  ///          otherwise dictionary stays empty.
+  ///
+  /// @param file dictionary file name
+  /// @param stamp content hash of current vocabulary list
+  /// @param slots the number of list slots, every id is lower
+  /// @retval true if mapped, false if absent, stale or broken
+  bool map(char* file, unsigned long long stamp, unsigned int slots);
+
+  /// @brief writing dictionary in mappable layout
+  ///
+  /// @param o output stream, opened in binary mode
+  /// @param stamp content hash of current vocabulary list
+  /// @param slots the number of list slots
+  void save(ostream* o, unsigned long long stamp, unsigned int slots);
+  /// @}
+};
+
+#endif /* __DICT__ */
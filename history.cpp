@@ -0,0 +1,493 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file history.cpp
+/// @brief Review History Source File
+/// @details Append-only binary log of test outcomes and streaming queries
+///
+/// @section purpose_section Purpose
+/// Keeping every review for retention analysis in few bytes per review
+///
+
+#include <time.h>
+#include "history.h"
+#include "intern.h"
+#include "strutil.h"
+
+#define HISTORY_MAGIC "VMLOG1" ///< file format tag, zero padded to 8 bytes
+#define MAGIC_SIZE    8        ///< bytes of file format tag
+#define VARINT_BYTES  10       ///< bytes of largest 64-bit varint
+#define WORD_MAX      4096     ///< longest word accepted by reader
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief HistoryWriter class functions implementation
+///
+
+HistoryWriter::HistoryWriter(char* file) : out(NULL), broken(false), last(-1)
+{
+  filename = Strjoin(file, (char*)"");
+}
+
+HistoryWriter::~HistoryWriter(void)
+{
+  if (out) {
+    out->close();
+    delete(out);
+  }
+  for (unsigned int k = 0; k < words.getSize(); k++)
+    StringPool::release(words.get(k));
+  delete[] filename;
+}
+
+void HistoryWriter::putVarint(unsigned long long v)
+{
+  while (v >= 0x80) {
+    out->put((char)(v | 0x80));
+    v >>= 7;
+  }
+  out->put((char)v);
+}
+
+bool HistoryWriter::open(void)
+{
+  char magic[MAGIC_SIZE + 1];
+  ifstream check(filename, ios::binary);
+  bool exists = check.good() && check.peek() != EOF;
+
+  if (exists) { // appended only if it is a log
+    check.read(magic, MAGIC_SIZE);
+    magic[MAGIC_SIZE] = '\0';
+    if (check.gcount() != MAGIC_SIZE ||
+        !Strequal((char*)HISTORY_MAGIC, magic)) {
+      broken = true;
+      return false;
+    }
+  }
+  check.close();
+
+  out = new ofstream(filename, ios::binary | ios::app);
+  if (!out->good()) {
+    delete(out);
+    out = NULL;
+    broken = true;
+    return false;
+  }
+
+  if (!exists) {
+    for (int c = 0; c < MAGIC_SIZE; c++)
+      magic[c] = '\0';
+    Strcpy(magic, (char*)HISTORY_MAGIC);
+    out->write(magic, MAGIC_SIZE);
+  }
+  return true;
+}
+
+void HistoryWriter::startBlock(long base)
+{
+  putVarint(0);
+  putVarint((unsigned long long)base);
+  last = base;
+
+  ids.clear();
+  for (unsigned int k = 0; k < words.getSize(); k++)
+    StringPool::release(words.get(k));
+  words.clear();
+}
+
+bool HistoryWriter::append(char* word, long time, int level, bool correct,
+                           unsigned int ms)
+{
+  if (broken || (!out && !open()))
+    return false;
+
+  if (last < 0 || time < last) // deltas stay unsigned
+    startBlock(time);
+
+  bool defined = false;
+  int id = ids.find(word);
+  if (id < 0) {
+    id = words.getSize();
+    char *key = StringPool::share(word); // alive while block lasts
+    if (!words.add(key)) {
+      StringPool::release(key);
+      return false;
+    }
+    if (!ids.insert(key, id)) {
+      startBlock(time); // ids are forgotten, word is written again
+      return false;
+    }
+    defined = true;
+  }
+
+  if (level < 0)
+    level = 0;
+  else if (level > 7)
+    level = 7;
+
+  putVarint(1 + (((unsigned long long)id << 4) | (level << 1) |
+                 (correct ? 1 : 0)));
+  if (defined) {
+    unsigned int length = Strlen(word);
+    putVarint(length);
+    out->write(word, length);
+  }
+  putVarint((unsigned long long)(time - last));
+  putVarint(ms);
+  last = time;
+
+  return true;
+}
+
+void HistoryWriter::flush(void)
+{
+  if (out)
+    out->flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief HistoryReader class functions implementation
+///
+
+HistoryReader::HistoryReader(istream *i) : in(i), pos(0), end(0),
+  started(false), inBlock(false), time(0), id(0), defined(false), level(0),
+  correct(false), ms(0)
+{
+}
+
+HistoryReader::~HistoryReader(void)
+{
+  clearWords();
+}
+
+void HistoryReader::clearWords(void)
+{
+  for (unsigned int k = 0; k < words.getSize(); k++)
+    delete[] words.get(k);
+  words.clear();
+}
+
+int HistoryReader::getByte(void)
+{
+  if (pos == end) {
+    in->read((char*)buffer, BUFFER);
+    end = (unsigned int)in->gcount();
+    pos = 0;
+    if (end == 0)
+      return -1;
+  }
+
+  return buffer[pos++];
+}
+
+bool HistoryReader::getVarint(unsigned long long &v)
+{
+  v = 0;
+  for (int shift = 0; shift < 7 * VARINT_BYTES; shift += 7) {
+    int b = getByte();
+    if (b < 0)
+      return false;
+    v |= (unsigned long long)(b & 0x7F) << shift;
+    if (b < 0x80)
+      return true;
+  }
+
+  return false;
+}
+
+char* HistoryReader::getWord(void)
+{
+  return words.get(id);
+}
+
+unsigned int HistoryReader::getId(void) const
+{
+  return id;
+}
+
+bool HistoryReader::isDefined(void) const
+{
+  return defined;
+}
+
+long HistoryReader::getTime(void) const
+{
+  return time;
+}
+
+int HistoryReader::getLevel(void) const
+{
+  return level;
+}
+
+bool HistoryReader::isCorrect(void) const
+{
+  return correct;
+}
+
+unsigned int HistoryReader::getMs(void) const
+{
+  return ms;
+}
+
+int HistoryReader::next(void)
+{
+  if (!started) {
+    char magic[MAGIC_SIZE + 1];
+    int c = 0;
+    for (; c < MAGIC_SIZE; c++) {
+      int b = getByte();
+      if (b < 0)
+        break;
+      magic[c] = (char)b;
+    }
+    if (c == 0)
+      return 0; // empty log
+    magic[c] = '\0';
+    if (c < MAGIC_SIZE || !Strequal((char*)HISTORY_MAGIC, magic))
+      return -1;
+    started = true;
+  }
+
+  for (;;) {
+    if (getByte() < 0)
+      return 0; // log ends between events
+    pos--;
+
+    unsigned long long head;
+    if (!getVarint(head))
+      return -1;
+
+    if (head == 0) { // block
+      unsigned long long base;
+      if (!getVarint(base))
+        return -1;
+      time = (long)base;
+      clearWords();
+      inBlock = true;
+      continue;
+    }
+    if (!inBlock)
+      return -1;
+
+    unsigned long long code = head - 1;
+    if ((code >> 4) > words.getSize())
+      return -1;
+    id = (unsigned int)(code >> 4);
+    level = (int)((code >> 1) & 7);
+    correct = (code & 1) != 0;
+
+    defined = (id == words.getSize());
+    if (defined) { // word follows its first id
+      unsigned long long length;
+      if (!getVarint(length) || length > WORD_MAX)
+        return -1;
+      char *word = new char[length + 1];
+      for (unsigned int k = 0; k < length; k++) {
+        int b = getByte();
+        if (b < 0) {
+          delete[] word;
+          return -1;
+        }
+        word[k] = (char)b;
+      }
+      word[length] = '\0';
+      if (!words.add(word)) {
+        delete[] word;
+        return -1;
+      }
+    }
+
+    unsigned long long delta, response;
+    if (!getVarint(delta) || !getVarint(response))
+      return -1;
+    time += (long)delta;
+    ms = (unsigned int)response;
+    return 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief HistoryTally class functions implementation
+///
+
+static int byRowWord(HistoryTally::Row* a, HistoryTally::Row* b) {
+  return Strcmp(a->word, b->word);
+}
+
+static int byRowKey(HistoryTally::Row* a, HistoryTally::Row* b) {
+  if (a->key != b->key)
+    return (a->key < b->key) ? -1 : 1;
+  return 0;
+}
+
+/// @brief getting local day of time, with its first and last second
+///
+/// @param t seconds since epoch
+/// @param start receiving local midnight starting day
+/// @param end receiving local midnight ending day
+/// @retval day as yyyymmdd
+static long localDay(long t, long &start, long &end) {
+  time_t now = (time_t)t;
+  struct tm day;
+  localtime_r(&now, &day);
+  long key = (day.tm_year + 1900) * 10000L + (day.tm_mon + 1) * 100
+    + day.tm_mday;
+
+  day.tm_hour = 0; day.tm_min = 0; day.tm_sec = 0;
+  day.tm_isdst = -1;
+  start = (long)mktime(&day);
+  day.tm_mday++;
+  day.tm_hour = 0; day.tm_min = 0; day.tm_sec = 0;
+  day.tm_isdst = -1;
+  end = (long)mktime(&day);
+
+  if (t < start || t >= end) // odd zone rule, no range is cached
+    start = end = t;
+  return key;
+}
+
+HistoryTally::HistoryTally(int g) : group(g), lastRow(-1), dayStart(0),
+  dayEnd(0)
+{
+  total.word = NULL;
+  total.key = 0;
+  total.reviews = total.correct = total.timed = total.msSum = 0;
+}
+
+HistoryTally::~HistoryTally(void)
+{
+  for (unsigned int r = 0; r < rows.getSize(); r++) {
+    Row *row = rows.get(r);
+    if (row->word)
+      delete[] row->word;
+    delete(row);
+  }
+}
+
+int HistoryTally::parseGroup(char* name)
+{
+  if (Strequal(name, (char*)"word"))
+    return BY_WORD;
+  if (Strequal(name, (char*)"level"))
+    return BY_LEVEL;
+  if (Strequal(name, (char*)"day"))
+    return BY_DAY;
+
+  return -1;
+}
+
+HistoryTally::Row* HistoryTally::rowOf(HistoryReader* reader)
+{
+  int r = -1;
+  long key = 0;
+
+  if (group == BY_WORD) {
+    if (reader->isDefined()) { // id is looked up once per block
+      r = byWord.find(reader->getWord());
+      if (r < 0) {
+        Row *row = new Row();
+        row->word = Strjoin(reader->getWord(), (char*)"");
+        row->key = 0;
+        row->reviews = row->correct = row->timed = row->msSum = 0;
+        r = rows.getSize();
+        if (!rows.add(row) || !byWord.insert(row->word, r))
+          return NULL;
+      }
+      bool good = (reader->getId() < local.getSize())
+        ? local.set(reader->getId(), r) : local.add(r);
+      if (!good)
+        return NULL;
+    }
+    return rows.get(local.get(reader->getId()));
+  }
+
+  if (group == BY_LEVEL) {
+    key = reader->getLevel();
+  } else { // days of consecutive events are mostly same
+    long t = reader->getTime();
+    if (lastRow >= 0 && t >= dayStart && t < dayEnd)
+      return rows.get(lastRow);
+    key = localDay(t, dayStart, dayEnd);
+  }
+
+  for (unsigned int k = 0; k < rows.getSize() && r < 0; k++) {
+    if (rows.get(k)->key == key)
+      r = k;
+  }
+  if (r < 0) {
+    Row *row = new Row();
+    row->word = NULL;
+    row->key = key;
+    row->reviews = row->correct = row->timed = row->msSum = 0;
+    r = rows.getSize();
+    if (!rows.add(row)) {
+      delete(row);
+      return NULL;
+    }
+  }
+
+  lastRow = r;
+  return rows.get(r);
+}
+
+void HistoryTally::count(Row* row, HistoryReader* reader)
+{
+  row->reviews++;
+  if (reader->isCorrect())
+    row->correct++;
+  if (reader->getMs() > 0) {
+    row->timed++;
+    row->msSum += reader->getMs();
+  }
+}
+
+bool HistoryTally::read(istream* in)
+{
+  HistoryReader reader(in);
+  int status;
+
+  while ((status = reader.next()) > 0) {
+    Row *row = rowOf(&reader);
+    if (!row)
+      return false;
+    count(row, &reader);
+    count(&total, &reader);
+  }
+
+  return status == 0;
+}
+
+void HistoryTally::print(ostream* o, Row* row, bool all)
+{
+  if (all) {
+    *o << "total";
+  } else if (group == BY_WORD) {
+    *o << row->word;
+  } else if (group == BY_LEVEL) {
+    *o << "level" << row->key;
+  } else {
+    char date[16];
+    struct tm day = tm();
+    day.tm_year = (int)(row->key / 10000) - 1900;
+    day.tm_mon = (int)(row->key / 100 % 100) - 1;
+    day.tm_mday = (int)(row->key % 100);
+    strftime(date, sizeof(date), "%Y-%m-%d", &day);
+    *o << date;
+  }
+
+  *o << "\treviews " << row->reviews << "\tcorrect " << row->correct
+    << "\taccuracy " << (row->reviews ? row->correct * 100 / row->reviews : 0)
+    << "\tavg_ms " << (row->timed ? row->msSum / row->timed : 0) << "\n";
+}
+
+void HistoryTally::report(ostream* o)
+{
+  rows.sort((group == BY_WORD) ? byRowWord : byRowKey);
+  lastRow = -1; // rows are moved
+
+  for (unsigned int r = 0; r < rows.getSize(); r++)
+    print(o, rows.get(r), false);
+  print(o, &total, true);
+}
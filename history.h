@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file history.h
+/// @brief Review History Header File
+/// @details Append-only binary log of test outcomes and streaming queries. @n
+///          File is magic "VMLOG1" padded to 8 bytes, then blocks. Every @n
+///          writer starts a block, so appending never reads old blocks. @n
+///          Each number below is a varint, 7 bits per byte, low bits first.
+///          @n
+///          block : 0, base time (seconds since epoch), events @n
+///          event : 1 + (id << 4 | level << 1 | correct), @n
+///                  [word length, word bytes] if id is new in block, @n
+///                  seconds since previous event (or base), @n
+///                  response milliseconds (0 : unknown) @n
+///          Ids are given to words in order of first review in a block, @n
+///          so a repeated word costs one byte of id instead of its text.
+///
+/// @section purpose_section Purpose
+/// Keeping every review for retention analysis in few bytes per review
+///
+
+#ifndef __HISTORY__
+#define __HISTORY__
+
+#include <iostream>
+#include <fstream>
+#include "array.h"
+#include "wordhash.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Review History Writer Class
+/// @details File is opened at first append, so a deck which is never @n
+///          tested gets no log. Words are kept by StringPool reference @n
+///          while block lasts. Time going backwards starts a new block.
+///
+
+class HistoryWriter
+{
+private:
+  char *filename;               ///< log file name
+  ofstream *out;                ///< log stream, NULL until first append
+  bool broken;                  ///< true if file is not a log, nothing is written
+  long last;                    ///< time of previous event in block
+  WordHash ids;                 ///< id of each word in block
+  Array <char*> words;          ///< words of block by id, StringPool references
+
+  /// @brief appending varint
+  void putVarint(unsigned long long v);
+
+  /// @brief opening file and checking or writing magic
+  ///
+  /// @retval true if log can be appended
+  bool open(void);
+
+  /// @brief starting block, forgetting word ids
+  ///
+  /// @param base base time of block
+  void startBlock(long base);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having log file name
+  ///
+  /// @param file log file name
+  HistoryWriter(char* file);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor, flushing log
+  ~HistoryWriter(void);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief appending one test outcome
+  ///
+  /// @param word word string taken from StringPool
+  /// @param time test time, seconds since epoch
+  /// @param level level when word was asked, 1 to 7
+  /// @param correct true if answer was correct
+  /// @param ms response time in milliseconds, 0 if unknown
+  /// @retval true if appended
+  bool append(char* word, long time, int level, bool correct,
+              unsigned int ms);
+
+  /// @brief writing buffered events to file
+  void flush(void);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Review History Reader Class
+/// @details Reading one event at a time through a fixed buffer, so log @n
+///          of any length needs memory only for words of current block.
+///
+
+class HistoryReader
+{
+public:
+  static const int BUFFER = 65536;  ///< bytes read from stream at once
+
+private:
+  istream *in;                  ///< input stream (not owned)
+  unsigned char buffer[BUFFER]; ///< read buffer
+  unsigned int pos;             ///< next unread byte in buffer
+  unsigned int end;             ///< bytes in buffer
+  bool started;                 ///< whether magic is read
+  bool inBlock;                 ///< whether a block has started
+  long time;                    ///< time of current event
+  Array <char*> words;          ///< words of block by id (owned)
+  unsigned int id;              ///< id of current event
+  bool defined;                 ///< whether current event gave new id
+  int level;                    ///< level of current event
+  bool correct;                 ///< outcome of current event
+  unsigned int ms;              ///< response time of current event
+
+  /// @brief reading one byte
+  ///
+  /// @retval byte, -1 at end of stream
+  int getByte(void);
+
+  /// @brief reading varint
+  ///
+  /// @param v receiving value
+  /// @retval true if success, false if stream ends or varint is too long
+  bool getVarint(unsigned long long &v);
+
+  /// @brief freeing words of block
+  void clearWords(void);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having input stream
+  ///
+  /// @param i input stream, opened in binary mode
+  HistoryReader(istream *i);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~HistoryReader(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting word of current event, valid until block ends
+  char* getWord(void);
+
+  /// @brief getting block id of current word
+  /// @details Same id is same word until isDefined gives it again.
+  unsigned int getId(void) const;
+
+  /// @brief checking whether current event introduced its id
+  bool isDefined(void) const;
+
+  /// @brief getting time of current event, seconds since epoch
+  long getTime(void) const;
+
+  /// @brief getting level of word when it was asked
+  int getLevel(void) const;
+
+  /// @brief checking whether answer was correct
+  bool isCorrect(void) const;
+
+  /// @brief getting response time in milliseconds, 0 if unknown
+  unsigned int getMs(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief reading next event
+  ///
+  /// @retval 1 if an event is read
+  /// @retval 0 at end of log
+  /// @retval -1 if log is broken
+  int next(void);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Review History Tally Class
+/// @details Accuracy and mean response time grouped by word, level or day, @n
+///          counted while log streams by. Memory grows with the number of @n
+///          groups, not with the number of events.
+///
+
+class HistoryTally
+{
+public:
+  /// @name groups
+  /// @{
+  static const int BY_WORD = 0;   ///< one row per word
+  static const int BY_LEVEL = 1;  ///< one row per level when asked
+  static const int BY_DAY = 2;    ///< one row per local day
+  /// @}
+
+  /// @brief counts of one group
+  struct Row
+  {
+    char *word;                 ///< word (owned), BY_WORD only
+    long key;                   ///< level, or local day as yyyymmdd
+    unsigned long long reviews; ///< events
+    unsigned long long correct; ///< correct events
+    unsigned long long timed;   ///< events with response time
+    unsigned long long msSum;   ///< sum of response times
+  };
+
+private:
+  int group;                    ///< grouping
+  Array <Row*> rows;            ///< groups in order of first event
+  WordHash byWord;              ///< row of each word, BY_WORD only
+  Array <int> local;            ///< row of each block id, BY_WORD only
+  int lastRow;                  ///< row of previous event, -1 if none
+  long dayStart;                ///< first second of local day of lastRow
+  long dayEnd;                  ///< first second of next local day
+  Row total;                    ///< counts of every event
+
+  /// @brief finding or adding row of current event
+  ///
+  /// @param reader reader at current event
+  /// @retval row, NULL if memory fails
+  Row* rowOf(HistoryReader* reader);
+
+  /// @brief counting one event into row
+  static void count(Row* row, HistoryReader* reader);
+
+  /// @brief writing one row
+  void print(ostream* o, Row* row, bool all);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having grouping
+  ///
+  /// @param g BY_WORD, BY_LEVEL or BY_DAY
+  HistoryTally(int g);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~HistoryTally(void);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief getting grouping from its name
+  ///
+  /// @param name "word", "level" or "day"
+  /// @retval grouping, -1 if name is unknown
+  static int parseGroup(char* name);
+
+  /// @brief counting every event of log
+  ///
+  /// @param in log stream, opened in binary mode
+  /// @retval true if whole log is read, false if it is broken
+  bool read(istream* in);
+
+  /// @brief writing rows in key order and total
+  ///
+  /// @param o output stream
+  void report(ostream* o);
+  /// @}
+};
+
+#endif /* __HISTORY__ */
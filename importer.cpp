@@ -0,0 +1,349 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file importer.cpp
+/// @brief Bulk Import Source File
+/// @details Streaming CSV/TSV record reader and multi-threaded similarity scan
+///
+/// @section purpose_section Purpose
+/// Importing thousands of words without prompt
+///
+
+#include <pthread.h>
+#include <unistd.h>
+#include "importer.h"
+#include "strutil.h"
+
+// column names of header row, per field
+static const char *COLUMN[RecordReader::FIELDS][4] = {
+  { "word", "words", NULL, NULL },
+  { "meaning", "mean", "meanings", NULL },
+  { "explanation", "explain", "expl", "example" }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief RecordReader class functions implementation
+///
+
+RecordReader::RecordReader(istream *i) : in(i), delim('\0'), end(0),
+  fields(0), line(0), records(0)
+{
+  capacity = 256;
+  buf = new char[capacity];
+  buf[0] = '\0';
+  for (int k = 0; k < FIELDS; k++)
+    start[k] = 0;
+}
+
+RecordReader::~RecordReader(void)
+{
+  delete[] buf;
+}
+
+void RecordReader::put(unsigned int &len, char c)
+{
+  if (len + 1 >= capacity) {
+    char *newBuf = new char[capacity * 2];
+    for (unsigned int k = 0; k < len; k++)
+      newBuf[k] = buf[k];
+    delete[] buf;
+    buf = newBuf;
+    capacity *= 2;
+  }
+
+  buf[len++] = c;
+}
+
+char* RecordReader::getField(int k)
+{
+  if (k < 0 || k >= FIELDS)
+    return buf + end;
+
+  return buf + start[k];
+}
+
+unsigned long RecordReader::getLine(void) const
+{
+  return line;
+}
+
+int RecordReader::getFields(void) const
+{
+  return fields;
+}
+
+bool RecordReader::isHeader(void) const
+{
+  if (records != 1 || fields != FIELDS)
+    return false;
+
+  for (int k = 0; k < FIELDS; k++) {
+    char *name = Strtrim(buf + start[k], true);
+    bool known = false;
+    for (int n = 0; n < 4 && COLUMN[k][n] && !known; n++)
+      known = Strequal(name, (char*)COLUMN[k][n]);
+    delete[] name;
+
+    if (!known)
+      return false;
+  }
+
+  return true;
+}
+
+bool RecordReader::next(void)
+{
+  while (in->peek() != EOF) {
+    unsigned int len = 0;
+    int field = 0;
+    bool quoted = false;
+    bool empty = true;
+
+    line++;
+    start[0] = 0;
+
+    while (true) {
+      int c = in->get();
+
+      if (c == EOF)
+        break;
+
+      if (quoted) {
+        if (c == '"') {
+          if (in->peek() == '"') // doubled quote
+            put(len, (char)in->get());
+          else
+            quoted = false;
+        } else {
+          if (c == '\n')
+            line++;
+          put(len, (char)c);
+          empty = false;
+        }
+        continue;
+      }
+
+      if (c == '\n')
+        break;
+      if (c == '\r')
+        continue;
+
+      if (delim == '\0' && (c == '\t' || c == ','))
+        delim = (char)c; // first delimiter decides the format
+
+      if (c == delim) {
+        put(len, '\0');
+        if (++field < FIELDS)
+          start[field] = len;
+        continue;
+      }
+
+      if (c == '"' && (len == 0 || buf[len - 1] == '\0')) {
+        quoted = true; // quote at field start
+        continue;
+      }
+
+      if (field < FIELDS)
+        put(len, (char)c);
+      if (!isWhite((char)c))
+        empty = false; // extra field still makes record worth reporting
+    }
+
+    put(len, '\0');
+    end = len - 1;
+    fields = field + 1;
+    // missing fields point at the terminating character
+    for (int k = field + 1; k < FIELDS; k++)
+      start[k] = end;
+
+    if (!empty) {
+      records++;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief SimilarityScan class functions implementation
+///
+
+SimilarityScan::SimilarityScan(char** b, unsigned int nb, char** q,
+  unsigned int nq, int t) : base(b), baseSize(nb), query(q), querySize(nq),
+  threshold(t), nearSize(0), floor(NULL), near(NULL), nearScore(NULL),
+  nearCount(NULL), link(NULL), linkScore(NULL), cursor(0)
+{
+  best = new int[querySize + 1];
+  score = new int[querySize + 1];
+  for (unsigned int k = 0; k < querySize; k++) {
+    best[k] = -1;
+    score[k] = 0;
+  }
+}
+
+SimilarityScan::~SimilarityScan(void)
+{
+  delete[] best;
+  delete[] score;
+  if (near) {
+    delete[] near;
+    delete[] nearScore;
+    delete[] nearCount;
+    delete[] link;
+    delete[] linkScore;
+  }
+}
+
+int SimilarityScan::getBest(unsigned int q) const
+{
+  if (q >= querySize)
+    return -1;
+
+  return best[q];
+}
+
+int SimilarityScan::getScore(unsigned int q) const
+{
+  if (q >= querySize)
+    return 0;
+
+  return score[q];
+}
+
+int SimilarityScan::getNear(unsigned int q, int *out, int *sims) const
+{
+  if (q >= querySize || !near)
+    return 0;
+
+  for (int k = 0; k < nearCount[q]; k++) {
+    out[k] = near[q * nearSize + k];
+    sims[k] = nearScore[q * nearSize + k];
+  }
+  return nearCount[q];
+}
+
+unsigned int SimilarityScan::getLinks(unsigned int q) const
+{
+  if (q >= querySize || !link)
+    return 0;
+
+  return link[q].getSize();
+}
+
+int SimilarityScan::getLink(unsigned int q, unsigned int n, int &sim) const
+{
+  sim = linkScore[q].get(n);
+  return link[q].get(n);
+}
+
+void SimilarityScan::setNeighbors(int k, const int *f)
+{
+  if (near || k <= 0)
+    return;
+
+  nearSize = k;
+  floor = f;
+  near = new int[querySize * k + 1];
+  nearScore = new int[querySize * k + 1];
+  nearCount = new int[querySize + 1];
+  link = new Array <int>[querySize + 1];
+  linkScore = new Array <int>[querySize + 1];
+  for (unsigned int q = 0; q < querySize; q++)
+    nearCount[q] = 0;
+}
+
+void SimilarityScan::keep(unsigned int q, int other, int sim)
+{
+  int *list = near + q * nearSize;
+  int *value = nearScore + q * nearSize;
+
+  // lowest position whose word is worse, earlier word wins a tie
+  int p = nearCount[q];
+  while (p > 0 && value[p - 1] < sim)
+    p--;
+  if (p == nearSize)
+    return;
+
+  if (nearCount[q] < nearSize)
+    nearCount[q]++;
+  for (int k = nearCount[q] - 1; k > p; k--) {
+    list[k] = list[k - 1];
+    value[k] = value[k - 1];
+  }
+  list[p] = other;
+  value[p] = sim;
+}
+
+void* SimilarityScan::worker(void* arg)
+{
+  ((SimilarityScan*)arg)->work();
+  return NULL;
+}
+
+void SimilarityScan::work(void)
+{
+  while (true) {
+    unsigned int first = __sync_fetch_and_add(&cursor, CHUNK);
+    if (first >= querySize)
+      break;
+
+    unsigned int last = first + CHUNK;
+    if (last > querySize)
+      last = querySize;
+
+    // other queries follow base words when neighbors are collected
+    unsigned int others = baseSize + (near ? querySize : 0);
+    for (unsigned int q = first; q < last; q++) {
+      int type = Strtype(query[q]);
+
+      for (unsigned int b = 0; b < others; b++) {
+        char *other = (b < baseSize) ? base[b] : query[b - baseSize];
+        if (b == baseSize + q || Strtype(other) != type)
+          continue;
+
+        int sim = Strsim(other, query[q], type);
+        if (b < baseSize && sim > threshold && sim > score[q]) {
+          best[q] = b;
+          score[q] = sim;
+        }
+        if (!near || sim <= 0 || sim >= 100)
+          continue;
+
+        keep(q, b, sim);
+        if (b < baseSize && sim > floor[b] &&
+            (!link[q].add(b) || !linkScore[q].add(sim))) {
+          link[q].clear(); // lists of base words go stale, not wrong
+          linkScore[q].clear();
+        }
+      }
+    }
+  }
+}
+
+void SimilarityScan::run(int threads)
+{
+  if (threads <= 0)
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads <= 0)
+    threads = 1;
+  if ((unsigned int)threads > querySize / CHUNK + 1)
+    threads = querySize / CHUNK + 1; // no idle thread
+
+  cursor = 0;
+
+  // calling thread works too, so only threads - 1 are created
+  pthread_t *tid = new pthread_t[threads];
+  int created = 0;
+  for (int t = 1; t < threads; t++) {
+    if (pthread_create(&tid[created], NULL, worker, this) == 0)
+      created++;
+  }
+
+  work();
+
+  for (int t = 0; t < created; t++)
+    pthread_join(tid[t], NULL);
+  delete[] tid;
+}
@@ -0,0 +1,237 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file importer.h
+/// @brief Bulk Import Header File
+/// @details Streaming CSV/TSV record reader and multi-threaded similarity @n
+///          scan, which are used for importing large word list at once.
+///
+/// @section purpose_section Purpose
+/// Importing thousands of words without prompt
+///
+
+#ifndef __IMPORTER__
+#define __IMPORTER__
+
+#include <iostream>
+#include "array.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief CSV/TSV Record Reader Class
+/// @details Reading one record (word, meaning, explanation) at a time. @n
+///          Delimiter is decided by first unquoted tab or comma of input. @n
+///          Fields may be quoted with '"', and doubled quote means a quote @n
+///          character. Number of fields is kept, so records having fewer @n
+///          or more fields than three can be rejected by caller. First @n
+///          record made of column names (word, meaning, explanation) is @n
+///          known as header row.
+///
+
+class RecordReader
+{
+public:
+  static const int FIELDS = 3;  ///< the number of fields used
+
+private:
+  istream *in;                  ///< input stream (not owned)
+  char delim;                   ///< field delimiter, '\0' if undecided
+  char *buf;                    ///< current record buffer
+  unsigned int capacity;        ///< record buffer size
+  unsigned int start[FIELDS];   ///< field offsets in buffer
+  unsigned int end;             ///< offset of record terminator
+  int fields;                   ///< the number of fields of current record
+  unsigned long line;           ///< line number of current record
+  unsigned long records;        ///< the number of records read
+
+  /// @brief appending one character to record buffer
+  ///
+  /// @param len current length, increased by one
+  /// @param c character
+  void put(unsigned int &len, char c);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having input stream
+  ///
+  /// @param i input stream
+  RecordReader(istream *i);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~RecordReader(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting field of current record
+  ///
+  /// @param k field number, 0 : word, 1 : meaning, 2 : explanation
+  /// @retval field string, empty string if record has no such field
+  char* getField(int k);
+
+  /// @brief getting line number where current record starts
+  ///
+  /// @retval line number starting from 1
+  unsigned long getLine(void) const;
+
+  /// @brief getting the number of fields of current record
+  ///
+  /// @retval the number of fields, including ones after third
+  int getFields(void) const;
+
+  /// @brief checking whether current record is header row
+  /// @details Only first record is header, when each field is its column @n
+  ///          name ("word", "meaning", "explanation" or their short forms) @n
+  ///          in any ASCII case.
+  ///
+  /// @retval true if it is header row
+  bool isHeader(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief reading next non-empty record
+  ///
+  /// @retval true if record is read, false at end of input
+  bool next(void);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Parallel Similarity Scan Class
+/// @details For every query word, finding the most similar base word by @n
+///          Strsim, as findSim does. Queries are split into small chunks and @n
+///          worker threads take chunks until none is left, each writing only @n
+///          results of its own queries, so no lock is needed. @n
+///          Neighbor candidates may be collected in same pass, then queries @n
+///          are compared with each other too, and other word n is numbered @n
+///          as base index, or the number of base words + query index.
+///
+
+class SimilarityScan
+{
+private:
+  static const unsigned int CHUNK = 16;  ///< queries per work unit
+
+  char **base;                  ///< base words (not owned)
+  unsigned int baseSize;        ///< the number of base words
+  char **query;                 ///< query words (not owned)
+  unsigned int querySize;       ///< the number of query words
+  int threshold;                ///< minimum similarity percent (exclusive)
+  int *best;                    ///< best base index per query, -1 if none
+  int *score;                   ///< best similarity per query
+  int nearSize;                 ///< neighbors kept per query, 0 if not collected
+  const int *floor;             ///< similarity to beat per base word (not owned)
+  int *near;                    ///< most similar words, nearSize per query
+  int *nearScore;               ///< similarity of near words
+  int *nearCount;               ///< the number of near words per query
+  Array <int> *link;            ///< base words beating their floor, per query
+  Array <int> *linkScore;       ///< similarity of linked base words
+  volatile unsigned int cursor; ///< next query to be taken
+
+  /// @brief worker thread entry
+  ///
+  /// @param arg SimilarityScan instance
+  /// @retval always NULL
+  static void* worker(void* arg);
+
+  /// @brief scanning queries until no chunk is left
+  void work(void);
+
+  /// @brief keeping word among near words of query, as NeighborIndex does
+  ///
+  /// @param q query index
+  /// @param other other word number
+  /// @param sim similarity
+  void keep(unsigned int q, int other, int sim);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having base and query words
+  ///
+  /// @param b base words
+  /// @param nb the number of base words
+  /// @param q query words
+  /// @param nq the number of query words
+  /// @param t minimum similarity percent, exclusive
+  SimilarityScan(char** b, unsigned int nb, char** q, unsigned int nq, int t);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~SimilarityScan(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting most similar base word of query
+  ///
+  /// @param q query index
+  /// @retval base index, -1 if no base word passes threshold
+  int getBest(unsigned int q) const;
+
+  /// @brief getting similarity of most similar base word
+  ///
+  /// @param q query index
+  /// @retval similarity percent, 0 if there is none
+  int getScore(unsigned int q) const;
+
+  /// @brief getting most similar other words of query, most similar first
+  /// @details Words of same similarity are kept in number order.
+  ///
+  /// @param q query index
+  /// @param out buffer of k entries receiving other word numbers
+  /// @param sims buffer of k entries receiving similarities
+  /// @retval the number of near words
+  int getNear(unsigned int q, int *out, int *sims) const;
+
+  /// @brief getting the number of base words whose floor query beats
+  ///
+  /// @param q query index
+  /// @retval the number of links
+  unsigned int getLinks(unsigned int q) const;
+
+  /// @brief getting base word whose floor query beats
+  ///
+  /// @param q query index
+  /// @param n link number
+  /// @param sim receiving similarity
+  /// @retval base index
+  int getLink(unsigned int q, unsigned int n, int &sim) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief collecting neighbor candidates in same pass
+  /// @details For each query, k most similar other words are kept, and @n
+  ///          base word b is linked if similarity is above floor[b]. @n
+  ///          Similarity 0 and 100 (same word) are never kept.
+  ///
+  /// @param k neighbors kept per query
+  /// @param f similarity to beat per base word, 100 if none is wanted
+  void setNeighbors(int k, const int *f);
+
+  /// @brief running scan
+  ///
+  /// @param threads the number of worker threads, 0 for online CPUs
+  void run(int threads);
+  /// @}
+};
+
+#endif /* __IMPORTER__ */
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file intern.cpp
+/// @brief String Pool Source File
+/// @details Reference counted table of immutable strings
+///
+/// @section purpose_section Purpose
+/// Keeping one copy of strings which many vocabularies repeat
+///
+
+#include <pthread.h>
+#include "intern.h"
+#include "strutil.h"
+
+#define FNV_OFFSET    14695981039346656037ULL
+
+static pthread_mutex_t stripeLock[StringPool::STRIPES];
+static pthread_mutex_t labelLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t lockOnce = PTHREAD_ONCE_INIT;
+
+static void initLocks(void)
+{
+  for (unsigned int k = 0; k < StringPool::STRIPES; k++)
+    pthread_mutex_init(&stripeLock[k], NULL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief StringPool class functions implementation
+///
+
+StringPool::Stripe StringPool::stripe[STRIPES];
+char *StringPool::label[LABELS + 1] = { (char*)"" };
+unsigned int StringPool::labels = 0;
+unsigned char StringPool::labelIndex[LABEL_SLOTS];
+
+StringPool::Entry* StringPool::entryOf(char* text)
+{
+  return (Entry*)(text - sizeof(Entry));
+}
+
+unsigned int StringPool::stripeOf(unsigned int hash)
+{
+  return (hash >> STRIPE_SHIFT) & (STRIPES - 1);
+}
+
+void StringPool::grow(Stripe* s)
+{
+  unsigned int newBuckets = (s->buckets == 0) ? 64 : s->buckets * 2;
+  Entry **newBucket = new Entry*[newBuckets];
+  for (unsigned int b = 0; b < newBuckets; b++)
+    newBucket[b] = NULL;
+
+  for (unsigned int b = 0; b < s->buckets; b++) {
+    Entry *e = s->bucket[b];
+    while (e) {
+      Entry *next = e->chain;
+      unsigned int nb = e->hash & (newBuckets - 1);
+      e->chain = newBucket[nb];
+      newBucket[nb] = e;
+      e = next;
+    }
+  }
+
+  if (s->bucket)
+    delete[] s->bucket;
+  s->bytes += (newBuckets - s->buckets) * sizeof(Entry*);
+  s->bucket = newBucket;
+  s->buckets = newBuckets;
+}
+
+unsigned int StringPool::getStrings(void)
+{
+  unsigned int size = 0;
+  for (unsigned int k = 0; k < STRIPES; k++)
+    size += stripe[k].size;
+
+  return size;
+}
+
+unsigned long StringPool::getBytes(void)
+{
+  unsigned long bytes = 0;
+  for (unsigned int k = 0; k < STRIPES; k++)
+    bytes += stripe[k].bytes;
+
+  return bytes;
+}
+
+char* StringPool::intern(char* str)
+{
+  unsigned int h = (unsigned int)Strhash(str, FNV_OFFSET);
+  unsigned int n = stripeOf(h);
+  Stripe *s = &stripe[n];
+
+  pthread_once(&lockOnce, initLocks);
+  pthread_mutex_lock(&stripeLock[n]);
+  if (s->size >= 2 * s->buckets) // chains of two on average
+    grow(s);
+
+  unsigned int b = h & (s->buckets - 1);
+  for (Entry *e = s->bucket[b]; e; e = e->chain) {
+    char *text = (char*)(e + 1);
+    if (e->hash == h && Strequal(text, str)) {
+      e->refs++;
+      pthread_mutex_unlock(&stripeLock[n]);
+      return text;
+    }
+  }
+
+  unsigned int length = Strlen(str) + 1;
+  Entry *e = (Entry*)new char[sizeof(Entry) + length];
+  char *text = (char*)(e + 1);
+  Strcpy(text, str);
+  e->hash = h;
+  e->refs = 1;
+  e->chain = s->bucket[b];
+  s->bucket[b] = e;
+  s->size++;
+  s->bytes += sizeof(Entry) + length;
+  pthread_mutex_unlock(&stripeLock[n]);
+
+  return text;
+}
+
+char* StringPool::share(char* text)
+{
+  if (!text)
+    return NULL;
+
+  Entry *e = entryOf(text);
+  unsigned int n = stripeOf(e->hash);
+  pthread_mutex_lock(&stripeLock[n]); // pooled text means locks are ready
+  e->refs++;
+  pthread_mutex_unlock(&stripeLock[n]);
+
+  return text;
+}
+
+void StringPool::release(char* text)
+{
+  if (!text)
+    return;
+
+  Entry *e = entryOf(text);
+  unsigned int n = stripeOf(e->hash);
+  Stripe *s = &stripe[n];
+  pthread_mutex_lock(&stripeLock[n]);
+  if (--e->refs > 0) {
+    pthread_mutex_unlock(&stripeLock[n]);
+    return;
+  }
+
+  Entry **link = &s->bucket[e->hash & (s->buckets - 1)];
+  while (*link != e)
+    link = &(*link)->chain;
+  *link = e->chain;
+  s->size--;
+  s->bytes -= sizeof(Entry) + Strlen(text) + 1;
+  pthread_mutex_unlock(&stripeLock[n]);
+
+  delete[] (char*)e;
+}
+
+unsigned char StringPool::toLabel(char* str)
+{
+  char *text = intern(str); // one holder for good if it is new label
+  unsigned int slot = entryOf(text)->hash & (LABEL_SLOTS - 1);
+
+  pthread_mutex_lock(&labelLock);
+  // open addressing, slots are twice of labels so an empty one is met
+  for (; labelIndex[slot] != 0; slot = (slot + 1) & (LABEL_SLOTS - 1)) {
+    if (label[labelIndex[slot]] == text) {
+      unsigned char id = labelIndex[slot];
+      pthread_mutex_unlock(&labelLock);
+      release(text);
+      return id;
+    }
+  }
+  if (labels == LABELS) {
+    pthread_mutex_unlock(&labelLock);
+    release(text);
+    return 0;
+  }
+  label[++labels] = text; // written before any holder sees id
+  labelIndex[slot] = (unsigned char)labels;
+  pthread_mutex_unlock(&labelLock);
+
+  return (unsigned char)labels;
+}
+
+char* StringPool::ofLabel(unsigned char id)
+{
+  return label[id];
+}
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file intern.h
+/// @brief String Pool Header File
+/// @details Reference counted table of immutable strings
+///
+/// @section purpose_section Purpose
+/// Keeping one copy of strings which many vocabularies repeat
+///
+
+#ifndef __INTERN__
+#define __INTERN__
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief String Pool Class
+/// @details Every Voca string is taken from this pool, so same meaning or @n
+///          explanation of many words, and snapshot copy of a word, share @n
+///          one allocation. Entry header and text are one block, and text @n
+///          pointer leads back to its header without lookup. Pool is one @n
+///          for process, as engines of many decks and epoch reclamation @n
+///          of snapshot entries use it, and it is striped by upper hash @n
+///          bits into tables with own mutex, so threads importing or @n
+///          releasing different strings seldom wait each other. @n
+///          A few strings which many entries end with (meaning tags like @n
+///          "(한자)") are also kept as labels, named by one byte, which @n
+///          stay until process ends.
+///
+
+class StringPool
+{
+public:
+  static const int LABELS = 255;  ///< the number of labels, id 0 is none
+  static const unsigned int STRIPES = 64;  ///< the number of tables, power of two
+
+private:
+  static const unsigned int STRIPE_SHIFT = 26;  ///< hash bits under stripe bits
+  static const unsigned int LABEL_SLOTS = 512;  ///< label index slots, power of two
+
+  struct Entry
+  {
+    Entry *chain;               ///< next entry in bucket
+    unsigned int hash;          ///< lower half of FNV-1a hash of text
+    unsigned int refs;          ///< the number of holders
+  };                            // text follows header in same block
+
+  struct Stripe
+  {
+    Entry **bucket;             ///< bucket heads
+    unsigned int buckets;       ///< the number of buckets, power of two
+    unsigned int size;          ///< the number of strings
+    unsigned long bytes;        ///< bytes of every block and buckets
+  };
+
+  static Stripe stripe[STRIPES];  ///< tables chosen by upper hash bits
+  static char *label[LABELS + 1];  ///< pooled text of each label id
+  static unsigned int labels;   ///< the number of labels
+  static unsigned char labelIndex[LABEL_SLOTS];  ///< label ids by text hash
+
+  /// @brief getting header of pooled text
+  static Entry* entryOf(char* text);
+
+  /// @brief getting stripe number of hash
+  static unsigned int stripeOf(unsigned int hash);
+
+  /// @brief doubling buckets of one stripe, rehashing with cached hash
+  static void grow(Stripe* s);
+
+public:
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of distinct strings
+  static unsigned int getStrings(void);
+
+  /// @brief getting bytes of pooled strings and buckets
+  static unsigned long getBytes(void);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief getting pooled copy of string, adding one holder
+  ///
+  /// @param str string, which is copied on first use
+  /// @retval pooled string, which must not be changed
+  static char* intern(char* str);
+
+  /// @brief adding one holder to pooled string, without hashing it
+  ///
+  /// @param text string returned by intern, or NULL
+  /// @retval same string
+  static char* share(char* text);
+
+  /// @brief removing one holder, freeing string with the last one
+  ///
+  /// @param text string returned by intern, or NULL
+  static void release(char* text);
+
+  /// @brief getting label id of string, adding it on first use
+  ///
+  /// @param str string, which is interned on first use
+  /// @retval label id, 0 if every id is taken
+  static unsigned char toLabel(char* str);
+
+  /// @brief getting text of label, without lock
+  ///
+  /// @param id label id which toLabel returned
+  /// @retval pooled string, empty string for 0
+  static char* ofLabel(unsigned char id);
+  /// @}
+};
+
+#endif /* __INTERN__ */
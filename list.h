@@ -260,12 +260,8 @@ public:
   /// @retval true if success, false if fail
   bool addNode(T content)
   {
-    ListNode <T>* last = NULL;
-    // choose last node
-    if (size == 0)
-      last = getHead();
-    else
-      last = getNode(size - 1);
+    // choose last node, which head links as previous (cyclic)
+    ListNode <T>* last = head->getPrev();
     
     if (ListNode <T>* newNode = new ListNode <T>(last, head, content)) {
       // link new node
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file loadgen.cpp
+/// @brief Load Generator Source File
+/// @details Multi-threaded client of deck server
+///
+/// @section purpose_section Purpose
+/// Measuring deck server requests per second and tail latency
+///
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "loadgen.h"
+#include "array.h"
+#include "strutil.h"
+
+/// @brief reading monotonic clock
+///
+/// @retval nanoseconds
+static inline long long nowNano(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief LoadGenerator class functions implementation
+///
+
+LoadGenerator::LoadGenerator(char* p, int c, int r) : clients(c),
+  requests(r), errors(0)
+{
+  path = new char[sizeof(char) * Strlen(p) + 1];
+  Strcpy(path, p);
+
+  if (clients < 1)
+    clients = 1;
+  if (requests < 1)
+    requests = 1;
+  latency = new long long[(long)clients * requests];
+}
+
+LoadGenerator::~LoadGenerator(void)
+{
+  delete[] path;
+  delete[] latency;
+}
+
+int LoadGenerator::compare(long long a, long long b)
+{
+  return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+void* LoadGenerator::worker(void* arg)
+{
+  Client *client = (Client*)arg;
+  client->owner->work(client->id);
+  return NULL;
+}
+
+void LoadGenerator::work(int id)
+{
+  long long *mine = latency + (long)id * requests;
+  for (int r = 0; r < requests; r++)
+    mine[r] = -1; // failed unless replied
+
+  struct sockaddr_un addr;
+  if (Strlen(path) >= (int)sizeof(addr.sun_path)) {
+    __sync_fetch_and_add(&errors, requests);
+    return;
+  }
+  addr.sun_family = AF_UNIX;
+  Strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    if (fd >= 0)
+      close(fd);
+    __sync_fetch_and_add(&errors, requests);
+    return;
+  }
+
+  char word[128] = "a";
+  char request[160];
+  char buf[4096];
+  int len = 0;
+
+  for (int r = 0; r < requests; r++) {
+    // next gives a word, search looks it up, list reads a page
+    int n = 0;
+    const char *cmd = (r % 3 == 0) ? "next" : (r % 3 == 1) ? "search\t" : "list";
+    for (int k = 0; cmd[k] != '\0'; k++)
+      request[n++] = cmd[k];
+    if (r % 3 == 1) {
+      for (int k = 0; word[k] != '\0'; k++)
+        request[n++] = word[k];
+    }
+    request[n++] = '\n';
+
+    long long begin = nowNano();
+    if (send(fd, request, n, MSG_NOSIGNAL) != n)
+      break;
+
+    // read until "." line which ends a reply
+    bool done = false;
+    bool first = true;
+    while (!done) {
+      int start = 0;
+      for (int k = 0; k < len && !done; k++) {
+        if (buf[k] != '\n')
+          continue;
+        buf[k] = '\0';
+
+        if (first && r % 3 == 0 && !Strequal(buf + start, (char*)"none")) {
+          // question line : "question\tword\t..."
+          char *field = buf + start;
+          while (*field != '\0' && *field != '\t')
+            field++;
+          if (*field == '\t') {
+            int w = 0;
+            for (field++; *field != '\0' && *field != '\t' && w < 127; field++)
+              word[w++] = *field;
+            word[w] = '\0';
+          }
+        }
+        first = false;
+
+        if (buf[start] == '.' && buf[start + 1] == '\0')
+          done = true;
+        start = k + 1;
+      }
+
+      // keep partial line at buffer front
+      for (int k = start; k < len; k++)
+        buf[k - start] = buf[k];
+      len -= start;
+
+      if (done)
+        break;
+      if (len == (int)sizeof(buf))
+        len = 0; // overlong line, only terminator matters
+
+      ssize_t got = recv(fd, buf + len, sizeof(buf) - len, 0);
+      if (got <= 0)
+        break;
+      len += got;
+    }
+
+    if (!done)
+      break;
+    mine[r] = nowNano() - begin;
+  }
+
+  close(fd);
+
+  int failed = 0;
+  for (int r = 0; r < requests; r++) {
+    if (mine[r] < 0)
+      failed++;
+  }
+  if (failed > 0)
+    __sync_fetch_and_add(&errors, failed);
+}
+
+bool LoadGenerator::run(ostream* o)
+{
+  pthread_t *tid = new pthread_t[clients];
+  Client *arg = new Client[clients];
+  int created = 0;
+  errors = 0;
+
+  long long begin = nowNano();
+  for (int c = 0; c < clients; c++) {
+    arg[c].owner = this;
+    arg[c].id = c;
+    if (pthread_create(&tid[c], NULL, worker, &arg[c]) != 0)
+      break;
+    created++;
+  }
+  errors += (clients - created) * requests; // clients never started
+  for (int c = 0; c < created; c++)
+    pthread_join(tid[c], NULL);
+  long long elapsed = nowNano() - begin;
+
+  delete[] tid;
+  delete[] arg;
+
+  // only replied requests of started clients count
+  Array <long long> done;
+  for (int c = 0; c < created; c++) {
+    for (int r = 0; r < requests; r++) {
+      long long ns = latency[(long)c * requests + r];
+      if (ns >= 0)
+        done.add(ns);
+    }
+  }
+  done.sort(compare);
+
+  unsigned int count = done.getSize();
+  double seconds = elapsed / 1e9;
+  *o << "requests\t" << count << "\n";
+  *o << "errors\t" << errors << "\n";
+  *o << "seconds\t" << seconds << "\n";
+  *o << "rps\t" << (seconds > 0 ? (long)(count / seconds) : 0) << "\n";
+  if (count > 0) {
+    *o << "p50_us\t" << done.get(count / 2) / 1000 << "\n";
+    *o << "p99_us\t" << done.get((unsigned int)((count - 1) * 0.99)) / 1000 << "\n";
+    *o << "max_us\t" << done.get(count - 1) / 1000 << "\n";
+  }
+
+  return errors == 0;
+}
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file loadgen.h
+/// @brief Load Generator Header File
+/// @details Local client which drives deck server with many connections @n
+///          and measures throughput and latency.
+///
+/// @section purpose_section Purpose
+/// Measuring deck server requests per second and tail latency
+///
+
+#ifndef __LOADGEN__
+#define __LOADGEN__
+
+#include <iostream>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Load Generator Class
+/// @details Every client thread has own connection and sends requests one @n
+///          by one, cycling next, search of the word just given, and list. @n
+///          Latency of each request is kept, so percentiles are exact. @n
+///          Requests only read deck, so measuring never changes progress.
+///
+
+class LoadGenerator
+{
+private:
+  /// @brief client thread argument
+  struct Client
+  {
+    LoadGenerator *owner;       ///< generator
+    int id;                     ///< client number
+  };
+
+  char *path;                   ///< socket file path
+  int clients;                  ///< the number of client threads
+  int requests;                 ///< requests per client
+  long long *latency;           ///< nanoseconds of each request
+  volatile int errors;          ///< failed requests or connections
+
+  /// @brief client thread entry
+  ///
+  /// @param arg Client argument
+  /// @retval always NULL
+  static void* worker(void* arg);
+
+  /// @brief sending requests of one client
+  ///
+  /// @param id client number
+  void work(int id);
+
+  /// @brief comparing latencies for sort
+  static int compare(long long a, long long b);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having server and load size
+  ///
+  /// @param p socket file path
+  /// @param c the number of concurrent clients
+  /// @param r requests per client
+  LoadGenerator(char* p, int c, int r);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~LoadGenerator(void);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief running all clients and printing measurement
+  /// @details Printing requests, errors, seconds, requests per second and @n
+  ///          p50, p99, max latency in microseconds as key and value lines.
+  ///
+  /// @param o output stream
+  /// @retval true if every request succeeded
+  bool run(ostream* o);
+  /// @}
+};
+
+#endif /* __LOADGEN__ */
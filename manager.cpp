@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file manager.cpp
+/// @brief Deck Manager Source File
+/// @details Lazy deck loading with LRU cache and background flush
+///
+/// @section purpose_section Purpose
+/// Switching among many decks without reloading them
+///
+
+#include "manager.h"
+#include "strutil.h"
+
+#define DECK_SUFFIX ".dat"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckManager class functions implementation
+///
+
+DeckManager::DeckManager(char* d, unsigned long b) : budget(b), used(0),
+  cached(0), head(NULL), tail(NULL), queueHead(NULL), queueTail(NULL),
+  flushing(NULL), stopping(false)
+{
+  dir = new char[sizeof(char) * Strlen(d) + 1];
+  Strcpy(dir, d);
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&cond, NULL);
+  started = (pthread_create(&flusher, NULL, worker, this) == 0);
+}
+
+DeckManager::~DeckManager(void)
+{
+  // decks in memory are saved here, queued ones by flusher
+  while (head) {
+    Entry *e = head;
+    head = e->next;
+    delete(e->engine);
+    delete[] e->file;
+    delete(e);
+  }
+
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+  if (started)
+    pthread_join(flusher, NULL);
+
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+  delete[] dir;
+}
+
+unsigned int DeckManager::getCached(void) const
+{
+  return cached;
+}
+
+unsigned long DeckManager::getUsed(void) const
+{
+  return used;
+}
+
+void* DeckManager::worker(void* arg)
+{
+  ((DeckManager*)arg)->work();
+  return NULL;
+}
+
+void DeckManager::work(void)
+{
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (!queueHead && !stopping)
+      pthread_cond_wait(&cond, &lock);
+    if (!queueHead)
+      break; // stopping and drained
+
+    Entry *e = queueHead;
+    queueHead = e->next;
+    if (!queueHead)
+      queueTail = NULL;
+    flushing = e->file;
+    pthread_mutex_unlock(&lock);
+
+    delete(e->engine); // saving if dirty
+
+    pthread_mutex_lock(&lock);
+    flushing = NULL;
+    pthread_cond_broadcast(&cond);
+    delete[] e->file;
+    delete(e);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+char* DeckManager::resolve(char* name)
+{
+  int len = Strlen(name);
+  int suffix = Strlen((char*)DECK_SUFFIX);
+  bool path = (len >= suffix && Strequal(name + len - suffix, (char*)DECK_SUFFIX));
+  for (int k = 0; name[k] != '\0' && !path; k++) {
+    if (name[k] == '/')
+      path = true;
+  }
+
+  if (path) {
+    char *file = new char[len + 1];
+    Strcpy(file, name);
+    return file;
+  }
+
+  char *slash = Strjoin(dir, (char*)"/");
+  char *base = Strjoin(slash, name);
+  char *file = Strjoin(base, (char*)DECK_SUFFIX);
+  delete[] slash;
+  delete[] base;
+  return file;
+}
+
+void DeckManager::detach(Entry* e)
+{
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    head = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+  else
+    tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+void DeckManager::pushFront(Entry* e)
+{
+  e->prev = NULL;
+  e->next = head;
+  if (head)
+    head->prev = e;
+  head = e;
+  if (!tail)
+    tail = e;
+}
+
+void DeckManager::evict(void)
+{
+  // most recently used deck stays even beyond budget
+  while (used > budget && tail && tail != head) {
+    Entry *e = tail;
+    detach(e);
+    used -= e->bytes;
+    cached--;
+
+    if (!started) { // no flusher, save in place
+      delete(e->engine);
+      delete[] e->file;
+      delete(e);
+      continue;
+    }
+
+    e->engine->setQuiet(true); // saved while menu is shown
+    pthread_mutex_lock(&lock);
+    if (queueTail)
+      queueTail->next = e;
+    else
+      queueHead = e;
+    queueTail = e;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+VocaEngine* DeckManager::open(char* name)
+{
+  char *file = resolve(name);
+
+  // size of deck being left may have changed since it was opened
+  if (head) {
+    used -= head->bytes;
+    head->bytes = head->engine->getFootprint();
+    used += head->bytes;
+  }
+
+  for (Entry *e = head; e; e = e->next) {
+    if (Strequal(e->file, file)) {
+      delete[] file;
+      detach(e);
+      pushFront(e);
+      evict();
+      return e->engine;
+    }
+  }
+
+  // take back from flush queue, or wait while it is being saved
+  Entry *found = NULL;
+  pthread_mutex_lock(&lock);
+  Entry *prev = NULL;
+  for (Entry *e = queueHead; e; prev = e, e = e->next) {
+    if (Strequal(e->file, file)) {
+      if (prev)
+        prev->next = e->next;
+      else
+        queueHead = e->next;
+      if (queueTail == e)
+        queueTail = prev;
+      found = e;
+      break;
+    }
+  }
+  while (!found && flushing && Strequal(flushing, file))
+    pthread_cond_wait(&cond, &lock);
+  pthread_mutex_unlock(&lock);
+
+  if (found) {
+    delete[] file;
+    found->engine->setQuiet(false);
+  } else {
+    found = new Entry();
+    found->file = file;
+    found->engine = new VocaEngine(file, false); // menu shows loading
+  }
+
+  found->bytes = found->engine->getFootprint();
+  pushFront(found);
+  used += found->bytes;
+  cached++;
+  evict();
+
+  return found->engine;
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file manager.h
+/// @brief Deck Manager Header File
+/// @details Opening decks by name on demand and keeping recently used ones @n
+///          in memory within a byte budget.
+///
+/// @section purpose_section Purpose
+/// Switching among many decks without reloading them
+///
+
+#ifndef __MANAGER__
+#define __MANAGER__
+
+#include <pthread.h>
+#include "VocaMaster.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Deck Manager Class
+/// @details Loaded decks are kept in a least recently used list. When their @n
+///          estimated size passes budget, least recently used decks are @n
+///          handed to a flusher thread, which saves and frees them while user @n
+///          goes on. A deck opened again before its flush starts is taken @n
+///          back from flush queue without loading. Every method is called @n
+///          from one thread, only the flusher runs beside it. Decks print @n
+///          their load and save messages, except ones flushed in background.
+///
+
+class DeckManager
+{
+private:
+  /// @brief loaded deck
+  struct Entry
+  {
+    char *file;                 ///< data file name
+    VocaEngine *engine;         ///< loaded engine
+    unsigned long bytes;        ///< estimated memory of engine
+    Entry *prev;                ///< more recently used entry
+    Entry *next;                ///< less recently used entry, or next flush
+  };
+
+  char *dir;                    ///< directory of named decks
+  unsigned long budget;         ///< memory budget in bytes
+  unsigned long used;           ///< estimated memory of cached decks
+  unsigned int cached;          ///< the number of cached decks
+  Entry *head;                  ///< most recently used entry
+  Entry *tail;                  ///< least recently used entry
+  pthread_t flusher;            ///< flusher thread
+  pthread_mutex_t lock;         ///< guarding flush queue
+  pthread_cond_t cond;          ///< signaled when flush queue changes
+  Entry *queueHead;             ///< first deck waiting for flush
+  Entry *queueTail;             ///< last deck waiting for flush
+  char *flushing;               ///< file being flushed, NULL if none
+  bool stopping;                ///< true if flusher should exit
+  bool started;                 ///< true if flusher is running
+
+  /// @brief flusher thread entry
+  ///
+  /// @param arg DeckManager instance
+  /// @retval always NULL
+  static void* worker(void* arg);
+
+  /// @brief saving and freeing queued decks until manager stops
+  void work(void);
+
+  /// @brief making file name of deck name
+  ///
+  /// @param name deck name, or data file name if it has '/' or ".dat"
+  /// @retval new file name string
+  char* resolve(char* name);
+
+  /// @brief unlinking entry from least recently used list
+  void detach(Entry* e);
+
+  /// @brief linking entry as most recently used
+  void pushFront(Entry* e);
+
+  /// @brief handing least recently used decks to flusher within budget
+  void evict(void);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having deck directory and budget
+  ///
+  /// @param d directory of named decks
+  /// @param b memory budget in bytes, the current deck is kept beyond it
+  DeckManager(char* d, unsigned long b);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details Saving every deck, waiting for flusher to finish.
+  ~DeckManager(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of decks in memory
+  unsigned int getCached(void) const;
+
+  /// @brief getting estimated memory of decks in memory
+  unsigned long getUsed(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief opening deck, loading it unless it is in memory
+  /// @details Returned engine stays valid until next open or destruction.
+  ///
+  /// @param name deck name
+  /// @retval engine of deck
+  VocaEngine* open(char* name);
+  /// @}
+};
+
+#endif /* __MANAGER__ */
@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file merge.cpp
+/// @brief Deck Merge Source File
+/// @details Sort-merge join of two data files
+///
+/// @section purpose_section Purpose
+/// Merging and comparing decks without replaying every word
+///
+
+#include <fstream>
+#include "merge.h"
+#include "deckfile.h"
+#include "strutil.h"
+
+#define DAY_SECONDS 86400
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckMerge class functions implementation
+///
+
+DeckMerge::DeckMerge(int p) : policy(p), onlyA(0), onlyB(0), same(0),
+  conflict(0)
+{
+  deck[0] = new Array<Voca*>();
+  deck[1] = new Array<Voca*>();
+}
+
+DeckMerge::~DeckMerge(void)
+{
+  for (int d = 0; d < 2; d++) {
+    for (unsigned int i = 0; i < deck[d]->getSize(); i++)
+      delete(deck[d]->get(i));
+    delete(deck[d]);
+  }
+}
+
+int DeckMerge::parsePolicy(char* name)
+{
+  if (Strequal(name, (char*)"max"))
+    return POLICY_MAX;
+  if (Strequal(name, (char*)"latest"))
+    return POLICY_LATEST;
+  if (Strequal(name, (char*)"sum"))
+    return POLICY_SUM;
+
+  return -1;
+}
+
+unsigned int DeckMerge::getOnlyA(void) const
+{
+  return onlyA;
+}
+
+unsigned int DeckMerge::getOnlyB(void) const
+{
+  return onlyB;
+}
+
+unsigned int DeckMerge::getSame(void) const
+{
+  return same;
+}
+
+unsigned int DeckMerge::getConflict(void) const
+{
+  return conflict;
+}
+
+int DeckMerge::compare(Voca* a, Voca* b)
+{
+  return Strcmp(a->getWord(), b->getWord());
+}
+
+long DeckMerge::reviewed(Voca* v)
+{
+  if (v->getDue() == 0)
+    return 0;
+
+  // due was set from review time by gainScore or loseScore
+  if (v->getInterval() == 0)
+    return v->getDue() - Voca::RETRY_DELAY;
+  return v->getDue() - (long)v->getInterval() * DAY_SECONDS;
+}
+
+void DeckMerge::sumExp(Voca* a, Voca* b, int &l, int &x)
+{
+  // level n with exp e means (n - 1) * 100 + e experience in total
+  long total = (long)(a->getLevel() - 1) * 100 + a->getExp()
+             + (long)(b->getLevel() - 1) * 100 + b->getExp();
+
+  if (total >= (long)(Voca::MAX_LEVEL - 1) * 100 + 100) {
+    l = Voca::MAX_LEVEL; // maximum exp is 100
+    x = 100;
+  } else {
+    l = (int)(total / 100) + 1;
+    x = (int)(total % 100);
+  }
+}
+
+bool DeckMerge::equal(Voca* a, Voca* b)
+{
+  char meanA[Voca::MEAN_SIZE], meanB[Voca::MEAN_SIZE];
+  return a->getExp() == b->getExp() && a->getLevel() == b->getLevel()
+      && a->getDue() == b->getDue() && a->getInterval() == b->getInterval()
+      && Strequal(a->getMean(meanA), b->getMean(meanB))
+      && Strequal(a->getExplain(), b->getExplain());
+}
+
+Voca* DeckMerge::resolve(Voca* a, Voca* b)
+{
+  Voca *win = a;
+
+  if (policy == POLICY_LATEST) {
+    if (reviewed(b) > reviewed(a))
+      win = b;
+  } else { // max, and sum takes texts of higher one too
+    if (b->getLevel() > a->getLevel() ||
+        (b->getLevel() == a->getLevel() && b->getExp() > a->getExp()))
+      win = b;
+  }
+
+  int level = win->getLevel();
+  int exp = win->getExp();
+  long due = win->getDue();
+  int interval = win->getInterval();
+
+  if (policy == POLICY_SUM) {
+    sumExp(a, b, level, exp);
+
+    // schedule of more recent review
+    Voca *last = (reviewed(b) > reviewed(a)) ? b : a;
+    due = last->getDue();
+    interval = last->getInterval();
+  }
+
+  char mean[Voca::MEAN_SIZE];
+  return new Voca(win->getWord(), win->getMean(mean), win->getExplain(),
+                  exp, level, due, interval);
+}
+
+Voca* DeckMerge::fold(int d, unsigned int &pos)
+{
+  Voca *first = deck[d]->get(pos++);
+  char mean[Voca::MEAN_SIZE];
+  Voca *folded = new Voca(first->getWord(), first->getMean(mean),
+                          first->getExplain(), first->getExp(),
+                          first->getLevel(), first->getDue(),
+                          first->getInterval());
+
+  while (pos < deck[d]->getSize() &&
+         compare(deck[d]->get(pos), folded) == 0) {
+    Voca *next = resolve(folded, deck[d]->get(pos++));
+    delete(folded);
+    folded = next;
+  }
+
+  return folded;
+}
+
+bool DeckMerge::loadDeck(char* file, int d)
+{
+  unsigned int count = DeckShards::count(file);
+  if (count == 0)
+    return false;
+
+  // shards are read in turn, deck is sorted afterwards anyway
+  for (unsigned int k = 0; k < count; k++) {
+    char *name = DeckShards::name(file, k, count);
+    ifstream *fin = new ifstream(name);
+    delete[] name;
+    if (!fin->good()) {
+      delete(fin);
+      return false;
+    }
+
+    DeckReader reader(fin);
+    int status;
+    while ((status = reader.next()) > 0)
+      deck[d]->add(new Voca(reader.getWord(), reader.getMean(),
+                            reader.getExplain(), reader.getExp(),
+                            reader.getLevel(), reader.getDue(),
+                            reader.getInterval()));
+    delete(fin);
+
+    if (status < 0)
+      return false;
+  }
+
+  deck[d]->sort(compare);
+  return true;
+}
+
+bool DeckMerge::load(char* fileA, char* fileB)
+{
+  return loadDeck(fileA, 0) && loadDeck(fileB, 1);
+}
+
+void DeckMerge::printProgress(ostream* report, Voca* v)
+{
+  *report << v->getLevel() << "/" << v->getExp();
+}
+
+void DeckMerge::merge(ostream* out, ostream* report)
+{
+  DeckWriter writer(out);
+  char mean[Voca::MEAN_SIZE];
+  unsigned int i = 0, j = 0;
+  onlyA = onlyB = same = conflict = 0;
+
+  while (i < deck[0]->getSize() || j < deck[1]->getSize()) {
+    int cmp;
+    if (i >= deck[0]->getSize())
+      cmp = 1;
+    else if (j >= deck[1]->getSize())
+      cmp = -1;
+    else
+      cmp = compare(deck[0]->get(i), deck[1]->get(j));
+
+    Voca *result;
+    if (cmp < 0) {
+      result = fold(0, i);
+      onlyA++;
+    } else if (cmp > 0) {
+      result = fold(1, j);
+      onlyB++;
+    } else {
+      Voca *a = fold(0, i);
+      Voca *b = fold(1, j);
+
+      if (equal(a, b)) {
+        result = new Voca(a->getWord(), a->getMean(mean), a->getExplain(),
+                          a->getExp(), a->getLevel(), a->getDue(),
+                          a->getInterval());
+        same++;
+      } else {
+        result = resolve(a, b);
+        conflict++;
+
+        *report << "conflict\t" << a->getWord() << "\t";
+        printProgress(report, a);
+        *report << "\t";
+        printProgress(report, b);
+        *report << "\t";
+        printProgress(report, result);
+        *report << endl;
+      }
+      delete(a);
+      delete(b);
+    }
+
+    writer.write(result->getWord(), result->getMean(mean), result->getExplain(),
+                 result->getExp(), result->getLevel(), result->getDue(),
+                 result->getInterval());
+    delete(result);
+  }
+}
+
+void DeckMerge::diff(ostream* report)
+{
+  unsigned int i = 0, j = 0;
+  onlyA = onlyB = same = conflict = 0;
+
+  while (i < deck[0]->getSize() || j < deck[1]->getSize()) {
+    int cmp;
+    if (i >= deck[0]->getSize())
+      cmp = 1;
+    else if (j >= deck[1]->getSize())
+      cmp = -1;
+    else
+      cmp = compare(deck[0]->get(i), deck[1]->get(j));
+
+    if (cmp < 0) {
+      Voca *a = fold(0, i);
+      *report << "only_a\t" << a->getWord() << endl;
+      onlyA++;
+      delete(a);
+    } else if (cmp > 0) {
+      Voca *b = fold(1, j);
+      *report << "only_b\t" << b->getWord() << endl;
+      onlyB++;
+      delete(b);
+    } else {
+      Voca *a = fold(0, i);
+      Voca *b = fold(1, j);
+
+      if (equal(a, b)) {
+        same++;
+      } else {
+        conflict++;
+
+        *report << "changed\t" << a->getWord() << "\t";
+        const char *sep = "";
+        char meanA[Voca::MEAN_SIZE], meanB[Voca::MEAN_SIZE];
+        if (!Strequal(a->getMean(meanA), b->getMean(meanB))) {
+          *report << sep << "meaning";
+          sep = ",";
+        }
+        if (!Strequal(a->getExplain(), b->getExplain())) {
+          *report << sep << "explain";
+          sep = ",";
+        }
+        if (a->getExp() != b->getExp()) {
+          *report << sep << "exp";
+          sep = ",";
+        }
+        if (a->getLevel() != b->getLevel()) {
+          *report << sep << "level";
+          sep = ",";
+        }
+        if (a->getDue() != b->getDue()) {
+          *report << sep << "due";
+          sep = ",";
+        }
+        if (a->getInterval() != b->getInterval())
+          *report << sep << "interval";
+        *report << endl;
+      }
+      delete(a);
+      delete(b);
+    }
+  }
+}
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file merge.h
+/// @brief Deck Merge Header File
+/// @details Sort-merge join of two data files, which is used for combining @n
+///          decks kept on several machines and for comparing them.
+///
+/// @section purpose_section Purpose
+/// Merging and comparing decks without replaying every word
+///
+
+#ifndef __MERGE__
+#define __MERGE__
+
+#include <iostream>
+#include "VocaMaster.h"
+#include "array.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Deck Merge Class
+/// @details Each deck is read once by DeckReader and sorted by word in @n
+///          O(n log n). Both sorted decks are then walked together, so merged @n
+///          deck and report are written while walking, never built in memory. @n
+///          Same word in one deck is folded into one record by the policy too.
+///
+
+class DeckMerge
+{
+public:
+  /// @name conflict policies
+  /// @{
+  static const int POLICY_MAX = 0;     ///< higher level and exp wins
+  static const int POLICY_LATEST = 1;  ///< more recently reviewed wins
+  static const int POLICY_SUM = 2;     ///< experience of both is summed
+  /// @}
+
+private:
+  Array <Voca*> *deck[2];       ///< sorted records of each deck
+  int policy;                   ///< conflict policy
+  unsigned int onlyA;           ///< the number of words only in first deck
+  unsigned int onlyB;           ///< the number of words only in second deck
+  unsigned int same;            ///< the number of identical words
+  unsigned int conflict;        ///< the number of differing words
+
+  /// @brief comparing records by word, in byte order
+  static int compare(Voca* a, Voca* b);
+
+  /// @brief estimating when record was reviewed last
+  ///
+  /// @param v record
+  /// @retval time of last review, 0 if never reviewed
+  static long reviewed(Voca* v);
+
+  /// @brief summing experience of two records
+  ///
+  /// @param a first record
+  /// @param b second record
+  /// @param l summed level, capped at MAX_LEVEL
+  /// @param x summed exp
+  static void sumExp(Voca* a, Voca* b, int &l, int &x);
+
+  /// @brief checking whether two records of same word are identical
+  static bool equal(Voca* a, Voca* b);
+
+  /// @brief resolving two records of same word by the policy
+  ///
+  /// @param a first record, which wins ties
+  /// @param b second record
+  /// @retval new merged record
+  Voca* resolve(Voca* a, Voca* b);
+
+  /// @brief folding run of same word in one deck into one record
+  ///
+  /// @param d deck number
+  /// @param pos first index of the run, moved past the run
+  /// @retval new folded record
+  Voca* fold(int d, unsigned int &pos);
+
+  /// @brief reading and sorting one deck
+  /// @details Sharded deck is read from every shard file.
+  ///
+  /// @param file data file name
+  /// @param d deck number
+  /// @retval true if success, false if fail
+  bool loadDeck(char* file, int d);
+
+  /// @brief writing level and exp of record to report
+  static void printProgress(ostream* report, Voca* v);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having conflict policy
+  ///
+  /// @param p one of POLICY_MAX, POLICY_LATEST and POLICY_SUM
+  DeckMerge(int p);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~DeckMerge(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief parsing policy name
+  ///
+  /// @param name "max", "latest" or "sum"
+  /// @retval policy, -1 if unknown
+  static int parsePolicy(char* name);
+
+  /// @brief getting the number of words only in first deck
+  unsigned int getOnlyA(void) const;
+
+  /// @brief getting the number of words only in second deck
+  unsigned int getOnlyB(void) const;
+
+  /// @brief getting the number of identical words in both decks
+  unsigned int getSame(void) const;
+
+  /// @brief getting the number of words which differ between decks
+  unsigned int getConflict(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief reading and sorting both decks
+  ///
+  /// @param fileA first data file name
+  /// @param fileB second data file name
+  /// @retval true if success, false if either file is missing or broken
+  bool load(char* fileA, char* fileB);
+
+  /// @brief writing merged deck and conflict report
+  ///
+  /// @param out merged data file stream
+  /// @param report report stream, one "conflict" line per differing word
+  void merge(ostream* out, ostream* report);
+
+  /// @brief writing difference report
+  ///
+  /// @param report report stream, one line per word which is @n
+  ///               "only_a", "only_b" or "changed" with field names
+  void diff(ostream* report);
+  /// @}
+};
+
+#endif /* __MERGE__ */
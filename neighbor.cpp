@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file neighbor.cpp
+/// @brief Neighbor Index Source File
+/// @details Per-vocabulary list of most similar other vocabularies
+///
+/// @section purpose_section Purpose
+/// Serving multiple choice question without similarity scan
+///
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "neighbor.h"
+#include "strutil.h"
+
+#define SIM_MAGIC     "VMSIM2" ///< file format tag, with terminating zero
+
+/// @brief header of neighbor file, neighbor, similarity and known arrays @n
+///        of every slot follow it
+struct SimHeader
+{
+  char magic[8];                ///< SIM_MAGIC
+  unsigned long long stamp;     ///< content hash of vocabulary list
+  unsigned int size;            ///< the number of slots
+  unsigned int k;               ///< neighbors per slot
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief NeighborIndex class functions implementation
+///
+
+NeighborIndex::NeighborIndex(void) : nb(NULL), sim(NULL), known(NULL),
+  size(0), capacity(0), dirty(false), mapping(NULL), mapLength(0)
+{
+}
+
+NeighborIndex::~NeighborIndex(void)
+{
+  release();
+}
+
+void NeighborIndex::release(void)
+{
+  if (mapping) {
+    munmap(mapping, mapLength);
+    mapping = NULL;
+    mapLength = 0;
+  } else {
+    if (nb)
+      delete[] nb;
+    if (sim)
+      delete[] sim;
+    if (known)
+      delete[] known;
+  }
+  nb = sim = NULL;
+  known = NULL;
+}
+
+bool NeighborIndex::grow(unsigned int need)
+{
+  if (need <= capacity)
+    return true;
+
+  unsigned int newCap = (capacity == 0) ? 64 : capacity;
+  while (newCap < need)
+    newCap *= 2;
+
+  int *newNb = new int[newCap * K];
+  int *newSim = new int[newCap * K];
+  bool *newKnown = new bool[newCap];
+  if (!newNb || !newSim || !newKnown)
+    return false;
+
+  for (unsigned int i = 0; i < size * K; i++) {
+    newNb[i] = nb[i];
+    newSim[i] = sim[i];
+  }
+  for (unsigned int i = 0; i < size; i++)
+    newKnown[i] = known[i];
+
+  release();
+  nb = newNb;
+  sim = newSim;
+  known = newKnown;
+  capacity = newCap;
+  return true;
+}
+
+unsigned int NeighborIndex::getSize(void) const
+{
+  return size;
+}
+
+bool NeighborIndex::isKnown(unsigned int slot) const
+{
+  if (slot >= size)
+    return false;
+
+  return known[slot];
+}
+
+bool NeighborIndex::isDirty(void) const
+{
+  return dirty;
+}
+
+unsigned long NeighborIndex::getBytes(void) const
+{
+  if (mapping)
+    return mapLength;
+  return capacity * (2 * K * sizeof(int) + sizeof(bool));
+}
+
+int NeighborIndex::get(unsigned int slot, int *out) const
+{
+  if (slot >= size)
+    return 0;
+
+  int count = 0;
+  for (int k = 0; k < K && nb[slot * K + k] >= 0; k++)
+    out[count++] = nb[slot * K + k];
+
+  return count;
+}
+
+int NeighborIndex::getFloor(unsigned int slot) const
+{
+  if (slot >= size || !known[slot])
+    return 100;
+
+  if (nb[slot * K + K - 1] < 0)
+    return 0;
+  return sim[slot * K + K - 1];
+}
+
+bool NeighborIndex::add(void)
+{
+  if (!grow(size + 1))
+    return false;
+
+  for (int k = 0; k < K; k++) {
+    nb[size * K + k] = -1;
+    sim[size * K + k] = 0;
+  }
+  known[size] = false;
+  size++;
+
+  return true; // unknown slot has nothing to save
+}
+
+void NeighborIndex::renumber(const int *map)
+{
+  unsigned int kept = 0;
+
+  // kept never passes i, so lists move forward in place
+  for (unsigned int i = 0; i < size; i++) {
+    if (map[i] < 0)
+      continue;
+
+    bool lost = false;
+    for (int k = 0; k < K; k++) {
+      int n = nb[i * K + k];
+      if (n >= 0 && map[n] < 0)
+        lost = true;
+    }
+
+    for (int k = 0; k < K; k++) {
+      int n = nb[i * K + k];
+      nb[kept * K + k] = (n >= 0 && !lost) ? map[n] : -1;
+      sim[kept * K + k] = lost ? 0 : sim[i * K + k];
+    }
+    known[kept] = known[i] && !lost;
+    kept++;
+  }
+  size = kept;
+
+  dirty = true;
+}
+
+void NeighborIndex::clear(void)
+{
+  size = 0;
+  dirty = true;
+}
+
+void NeighborIndex::reset(unsigned int slot)
+{
+  if (slot >= size)
+    return;
+
+  for (int k = 0; k < K; k++) {
+    nb[slot * K + k] = -1;
+    sim[slot * K + k] = 0;
+  }
+  known[slot] = true;
+  dirty = true;
+}
+
+void NeighborIndex::offer(unsigned int slot, int other, int score)
+{
+  if (slot >= size || other == (int)slot)
+    return;
+
+  int *list = nb + slot * K;
+  int *value = sim + slot * K;
+
+  // lowest position whose neighbor is worse than candidate
+  int p = K;
+  while (p > 0 && (list[p - 1] < 0 || value[p - 1] < score))
+    p--;
+  if (p == K)
+    return;
+
+  for (int k = K - 1; k > p; k--) {
+    list[k] = list[k - 1];
+    value[k] = value[k - 1];
+  }
+  list[p] = other;
+  value[p] = score;
+  dirty = true;
+}
+
+bool NeighborIndex::map(char* file, unsigned long long stamp)
+{
+  int fd = open(file, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (unsigned long)st.st_size >= sizeof(SimHeader))
+    base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd); // mapping stays valid
+  if (base == MAP_FAILED)
+    return false;
+
+  SimHeader *header = (SimHeader*)base;
+  int *savedNb = (int*)(header + 1);
+  int *savedSim = savedNb + size * K;
+  unsigned char *savedKnown = (unsigned char*)(savedSim + size * K);
+  unsigned long length = (unsigned long)st.st_size;
+  bool good = Strequal((char*)SIM_MAGIC, header->magic) &&
+    header->stamp == stamp && header->size == size && header->k == K &&
+    length == sizeof(SimHeader) + size * (2 * K * sizeof(int) + sizeof(bool));
+
+  // lists are checked once here, then used in place
+  for (unsigned int i = 0; good && i < size * K; i++)
+    good = savedNb[i] >= -1 && savedNb[i] < (int)size;
+  for (unsigned int s = 0; good && s < size; s++)
+    good = savedKnown[s] <= 1;
+  if (!good) {
+    munmap(base, length);
+    return false;
+  }
+
+  release();
+  mapping = base;
+  mapLength = length;
+  nb = savedNb;
+  sim = savedSim;
+  known = (bool*)savedKnown;
+  capacity = size;
+  dirty = false;
+  return true;
+}
+
+void NeighborIndex::save(ostream* o, unsigned long long stamp)
+{
+  SimHeader header;
+  for (unsigned int c = 0; c < sizeof(header.magic); c++)
+    header.magic[c] = '\0';
+  Strcpy(header.magic, (char*)SIM_MAGIC);
+  header.stamp = stamp;
+  header.size = size;
+  header.k = K;
+  o->write((const char*)&header, sizeof(header));
+
+  o->write((const char*)nb, size * K * sizeof(int));
+  o->write((const char*)sim, size * K * sizeof(int));
+  o->write((const char*)known, size * sizeof(bool));
+
+  dirty = false;
+}
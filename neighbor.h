@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file neighbor.h
+/// @brief Neighbor Index Header File
+/// @details Per-vocabulary list of most similar other vocabularies, which @n
+///          is used as distractors of multiple choice test.
+///
+/// @section purpose_section Purpose
+/// Serving multiple choice question without similarity scan
+///
+
+#ifndef __NEIGHBOR__
+#define __NEIGHBOR__
+
+#include <iostream>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Nearest Neighbor Index Class
+/// @details Each slot keeps up to K neighbor slots sorted by similarity. @n
+///          A slot is either known (its list is complete) or unknown (never @n
+///          computed, or one of its neighbors was removed). The index does not @n
+///          score similarity itself; owner computes unknown lists and offers @n
+///          candidates, and the index keeps best K of them in O(K). @n
+///          Saved file is lists as they are in memory, so a matching file @n
+///          is mapped privately and changed in place without parsing.
+///
+
+class NeighborIndex
+{
+public:
+  static const int K = 3;       ///< the number of neighbors per slot
+
+private:
+  int *nb;                      ///< neighbor slots, K per slot, -1 if empty
+  int *sim;                     ///< neighbor similarity, K per slot
+  bool *known;                  ///< whether slot list is complete
+  unsigned int size;            ///< the number of slots
+  unsigned int capacity;        ///< the number of allocated slots
+  bool dirty;                   ///< whether index changed since last save
+  void *mapping;                ///< mapped file which lists point into, or NULL
+  unsigned long mapLength;      ///< bytes of mapping
+
+  /// @brief freeing lists, unmapping them if they are mapped
+  void release(void);
+
+  /// @brief growing buffers to hold at least need slots
+  ///
+  /// @param need required capacity
+  /// @retval true if success, false if fail
+  bool grow(unsigned int need);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  NeighborIndex(void);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~NeighborIndex(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of slots
+  ///
+  /// @retval the number of slots
+  unsigned int getSize(void) const;
+
+  /// @brief checking whether slot list is complete
+  ///
+  /// @param slot slot index
+  /// @retval true if known, false if it should be computed
+  bool isKnown(unsigned int slot) const;
+
+  /// @brief checking whether index changed since last save
+  ///
+  /// @retval true if changed
+  bool isDirty(void) const;
+
+  /// @brief getting bytes of buffers
+  ///
+  /// @retval allocated or mapped bytes
+  unsigned long getBytes(void) const;
+
+  /// @brief getting neighbors of slot, most similar first
+  ///
+  /// @param slot slot index
+  /// @param out buffer of K entries receiving neighbor slots
+  /// @retval the number of neighbors
+  int get(unsigned int slot, int *out) const;
+
+  /// @brief getting similarity which a candidate must beat to enter list
+  ///
+  /// @param slot slot index
+  /// @retval similarity of last neighbor, 0 if list has room, @n
+  ///         100 if slot is unknown (it is computed later anyway)
+  int getFloor(unsigned int slot) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief appending new unknown slot
+  ///
+  /// @retval true if success, false if fail
+  bool add(void);
+
+  /// @brief removing slots and renumbering the others in one pass
+  /// @details Remaining slots keep their order. Slots which had a removed @n
+  ///          slot as neighbor become unknown, other lists stay known.
+  ///
+  /// @param map new index of each slot, -1 if slot is removed
+  void renumber(const int *map);
+
+  /// @brief removing all slots
+  void clear(void);
+
+  /// @brief emptying slot list and marking it known
+  /// @details Owner offers every candidate right after this call.
+  ///
+  /// @param slot slot index
+  void reset(unsigned int slot);
+
+  /// @brief offering candidate neighbor to slot
+  ///
+  /// @param slot slot index
+  /// @param other candidate slot index
+  /// @param score similarity of candidate, higher is closer
+  void offer(unsigned int slot, int other, int score);
+
+  /// @brief mapping saved index file in place of current lists
+  /// @details File is accepted only if it was saved with same stamp, @n
+  ///          same slot count and same K, and every neighbor is a slot, @n
+  ///          otherwise every slot stays unknown. Mapping is private, so @n
+  ///          changes never reach the file.
+  ///
+  /// @param file index file name
+  /// @param stamp content hash of current vocabulary list
+  /// @retval true if mapped, false if absent, stale or broken
+  bool map(char* file, unsigned long long stamp);
+
+  /// @brief writing index in mappable layout
+  ///
+  /// @param o output stream, opened in binary mode
+  /// @param stamp content hash of current vocabulary list
+  void save(ostream *o, unsigned long long stamp);
+  /// @}
+};
+
+#endif /* __NEIGHBOR__ */
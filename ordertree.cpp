@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file ordertree.cpp
+/// @brief Order Tree Source File
+/// @details Order statistic tree of vocabularies for sorted list views
+///
+/// @section purpose_section Purpose
+/// Showing any page of deck in sorted order without sorting it again
+///
+
+#include "ordertree.h"
+
+#ifndef NULL
+#define NULL 0
+#endif  /* NULL */
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief OrderTree class functions implementation
+///
+
+OrderTree::OrderTree(Compare c) : root(NULL), compare(c), seed(2463534242U)
+{
+}
+
+OrderTree::~OrderTree(void)
+{
+  destroy(root);
+}
+
+int OrderTree::order(Voca* a, Voca* b) const
+{
+  int c = compare(a, b);
+  if (c != 0)
+    return c;
+
+  if (a < b)
+    return -1;
+  return (a > b) ? 1 : 0;
+}
+
+unsigned int OrderTree::sizeOf(Node* n)
+{
+  return n ? n->size : 0;
+}
+
+void OrderTree::update(Node* n)
+{
+  n->size = sizeOf(n->left) + sizeOf(n->right) + 1;
+}
+
+void OrderTree::split(Node* n, Voca* v, Node* &low, Node* &high)
+{
+  if (!n) {
+    low = high = NULL;
+    return;
+  }
+
+  if (order(n->voca, v) < 0) {
+    split(n->right, v, n->right, high);
+    low = n;
+  } else {
+    split(n->left, v, low, n->left);
+    high = n;
+  }
+  update(n);
+}
+
+OrderTree::Node* OrderTree::join(Node* low, Node* high)
+{
+  if (!low)
+    return high;
+  if (!high)
+    return low;
+
+  if (low->priority > high->priority) {
+    low->right = join(low->right, high);
+    update(low);
+    return low;
+  }
+
+  high->left = join(low, high->left);
+  update(high);
+  return high;
+}
+
+void OrderTree::destroy(Node* n)
+{
+  while (n) {
+    destroy(n->left);
+    Node *right = n->right;
+    delete(n);
+    n = right;
+  }
+}
+
+void OrderTree::renumber(Node* n, const int *map)
+{
+  while (n) {
+    renumber(n->left, map);
+    n->slot = map[n->slot];
+    n = n->right;
+  }
+}
+
+unsigned int OrderTree::getSize(void) const
+{
+  return sizeOf(root);
+}
+
+unsigned long OrderTree::getBytes(void) const
+{
+  return sizeOf(root) * sizeof(Node);
+}
+
+int OrderTree::select(unsigned int rank) const
+{
+  Node *n = root;
+
+  while (n) {
+    unsigned int left = sizeOf(n->left);
+    if (rank < left) {
+      n = n->left;
+    } else if (rank == left) {
+      return n->slot;
+    } else {
+      rank -= left + 1;
+      n = n->right;
+    }
+  }
+
+  return -1;
+}
+
+bool OrderTree::insert(Voca* v, unsigned int slot)
+{
+  Node *n = new Node();
+  if (!n)
+    return false;
+
+  // xorshift, fixed seed keeps tree shape same for same input
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+
+  n->voca = v;
+  n->slot = slot;
+  n->priority = seed;
+  n->size = 1;
+  n->left = n->right = NULL;
+
+  Node *low, *high;
+  split(root, v, low, high);
+  root = join(join(low, n), high);
+
+  return true;
+}
+
+bool OrderTree::remove(Voca* v)
+{
+  Node *n = root;
+  while (n) {
+    int c = order(v, n->voca);
+    if (c == 0)
+      break;
+    n = (c < 0) ? n->left : n->right;
+  }
+  if (!n)
+    return false;
+
+  // every ancestor loses one entry, found node is replaced by its children
+  Node **link = &root;
+  while (*link != n) {
+    (*link)->size--;
+    link = (order(v, (*link)->voca) < 0) ? &(*link)->left : &(*link)->right;
+  }
+  *link = join(n->left, n->right);
+  delete(n);
+
+  return true;
+}
+
+void OrderTree::clear(void)
+{
+  destroy(root);
+  root = NULL;
+}
+
+void OrderTree::renumber(const int *map)
+{
+  renumber(root, map);
+}
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file ordertree.h
+/// @brief Order Tree Header File
+/// @details Order statistic tree of vocabularies for sorted list views
+///
+/// @section purpose_section Purpose
+/// Showing any page of deck in sorted order without sorting it again
+///
+
+#ifndef __ORDERTREE__
+#define __ORDERTREE__
+
+class Voca;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Order Statistic Tree Class
+/// @details Treap whose nodes keep their subtree size, so insert, remove @n
+///          and finding the vocabulary of given rank are O(log n) expected. @n
+///          Vocabularies which compare equal are ordered by address, which @n
+///          makes every entry unique. Key fields of a vocabulary must not @n
+///          change while it is in the tree; remove it first and insert it @n
+///          again after the change.
+///
+
+class OrderTree
+{
+public:
+  /// @brief key comparison, negative, zero or positive as a is lower, @n
+  ///        equal or higher than b
+  typedef int (*Compare)(Voca* a, Voca* b);
+
+private:
+  /// @brief tree node
+  struct Node
+  {
+    Voca *voca;                 ///< entry (not owned)
+    unsigned int slot;          ///< list slot of entry
+    unsigned int priority;      ///< heap priority, higher is nearer root
+    unsigned int size;          ///< the number of nodes in subtree
+    Node *left;                 ///< lower subtree
+    Node *right;                ///< higher subtree
+  };
+
+  Node *root;                   ///< root node, NULL if empty
+  Compare compare;              ///< key comparison
+  unsigned int seed;            ///< priority generator state
+
+  /// @brief comparing entries by key and then by address
+  int order(Voca* a, Voca* b) const;
+
+  /// @brief getting subtree size of node, 0 for NULL
+  static unsigned int sizeOf(Node* n);
+
+  /// @brief recounting subtree size from children
+  static void update(Node* n);
+
+  /// @brief splitting subtree into entries lower than v and the others
+  ///
+  /// @param n subtree root
+  /// @param v pivot entry
+  /// @param low receiving lower part
+  /// @param high receiving the other part
+  void split(Node* n, Voca* v, Node* &low, Node* &high);
+
+  /// @brief merging two subtrees whose every entry of low is lower
+  ///
+  /// @retval merged subtree root
+  static Node* join(Node* low, Node* high);
+
+  /// @brief freeing subtree
+  static void destroy(Node* n);
+
+  /// @brief renumbering list slots of subtree
+  static void renumber(Node* n, const int *map);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having key comparison
+  ///
+  /// @param c key comparison
+  OrderTree(Compare c);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details As List does, entries themselves are not deleted.
+  ~OrderTree(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of entries
+  unsigned int getSize(void) const;
+
+  /// @brief getting bytes of nodes
+  ///
+  /// @retval allocated bytes
+  unsigned long getBytes(void) const;
+
+  /// @brief finding entry of given rank, O(log n)
+  ///
+  /// @param rank 0 for lowest entry
+  /// @retval list slot of entry, -1 if rank is out of range
+  int select(unsigned int rank) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief inserting entry, O(log n)
+  ///
+  /// @param v entry
+  /// @param slot list slot of entry
+  /// @retval true if success, false if fail
+  bool insert(Voca* v, unsigned int slot);
+
+  /// @brief removing entry, O(log n)
+  ///
+  /// @param v entry whose key is unchanged since insert
+  /// @retval true if removed, false if absent
+  bool remove(Voca* v);
+
+  /// @brief removing every entry
+  void clear(void);
+
+  /// @brief renumbering list slots after list is compacted, O(n)
+  ///
+  /// @param map new slot of each old slot, every entry must be kept
+  void renumber(const int *map);
+  /// @}
+};
+
+#endif /* __ORDERTREE__ */
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file pager.cpp
+/// @brief Deck Pager Source File
+/// @details Meaning and explanation read on demand from mapped data file
+///
+/// @section purpose_section Purpose
+/// Decks larger than memory, keeping only words and scores resident
+///
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pager.h"
+#include "strutil.h"
+
+static char emptyText[1] = { '\0' }; ///< text of broken record
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief DeckPager class functions implementation
+///
+
+DeckPager::DeckPager(char* file) : base(NULL), length(0), recent(0),
+  clock(0), hits(0), misses(0)
+{
+  for (int k = 0; k < CACHE; k++) {
+    entry[k].mean = NULL;
+    entry[k].explain = NULL;
+    entry[k].used = 0;
+  }
+  remap(file);
+}
+
+DeckPager::~DeckPager(void)
+{
+  drop();
+  if (base)
+    munmap(base, length);
+}
+
+bool DeckPager::isOpen(void) const
+{
+  return base != NULL;
+}
+
+unsigned long DeckPager::getHits(void) const
+{
+  return hits;
+}
+
+unsigned long DeckPager::getMisses(void) const
+{
+  return misses;
+}
+
+unsigned long DeckPager::getBytes(void) const
+{
+  unsigned long bytes = 0;
+  for (int k = 0; k < CACHE; k++) {
+    if (entry[k].mean)
+      bytes += Strlen(entry[k].mean) + Strlen(entry[k].explain) + 2;
+  }
+
+  return bytes;
+}
+
+void DeckPager::drop(void)
+{
+  for (int k = 0; k < CACHE; k++) {
+    if (entry[k].mean) {
+      delete[] entry[k].mean;
+      delete[] entry[k].explain;
+    }
+    entry[k].mean = NULL;
+    entry[k].explain = NULL;
+    entry[k].used = 0;
+  }
+}
+
+char* DeckPager::copyField(unsigned long &p)
+{
+  unsigned long end = p;
+  while (end < length && base[end] != '%' && base[end] != '$')
+    end++;
+  if (end >= length)
+    return NULL;
+
+  char *str = new char[end - p + 1];
+  for (unsigned long i = p; i < end; i++)
+    str[i - p] = base[i];
+  str[end - p] = '\0';
+  p = end + 1;
+
+  return str;
+}
+
+DeckPager::Entry* DeckPager::fetch(unsigned long long offset)
+{
+  // meaning and explanation of a record are asked one after another
+  if (entry[recent].mean && entry[recent].offset == offset) {
+    entry[recent].used = ++clock;
+    hits++;
+    return &entry[recent];
+  }
+
+  int victim = 0;
+  for (int k = 0; k < CACHE; k++) {
+    if (entry[k].mean && entry[k].offset == offset) {
+      entry[k].used = ++clock;
+      recent = k;
+      hits++;
+      return &entry[k];
+    }
+    if (entry[k].used < entry[victim].used)
+      victim = k;
+  }
+
+  if (!base || offset >= length)
+    return NULL;
+
+  // word, then meaning and explanation
+  unsigned long p = (unsigned long)offset;
+  char *skip = copyField(p);
+  char *mean = skip ? copyField(p) : NULL;
+  char *explain = mean ? copyField(p) : NULL;
+  if (skip)
+    delete[] skip;
+  if (!explain) {
+    if (mean)
+      delete[] mean;
+    return NULL;
+  }
+
+  Entry *e = &entry[victim];
+  if (e->mean) {
+    delete[] e->mean;
+    delete[] e->explain;
+  }
+  e->offset = offset;
+  e->mean = mean;
+  e->explain = explain;
+  e->used = ++clock;
+  recent = victim;
+  misses++;
+
+  return e;
+}
+
+char* DeckPager::getMean(unsigned long long offset)
+{
+  Entry *e = fetch(offset);
+  return e ? e->mean : emptyText;
+}
+
+char* DeckPager::getExplain(unsigned long long offset)
+{
+  Entry *e = fetch(offset);
+  return e ? e->explain : emptyText;
+}
+
+bool DeckPager::remap(char* file)
+{
+  int fd = open(file, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  void *map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // mapping stays valid
+  if (map == MAP_FAILED)
+    return false; // old mapping and its offsets stay usable
+
+  drop();
+  if (base)
+    munmap(base, length);
+  base = (char*)map;
+  length = (unsigned long)st.st_size;
+  return true;
+}
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file pager.h
+/// @brief Deck Pager Header File
+/// @details Meaning and explanation read on demand from mapped data file
+///
+/// @section purpose_section Purpose
+/// Decks larger than memory, keeping only words and scores resident
+///
+
+#ifndef __PAGER__
+#define __PAGER__
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Deck Pager Class
+/// @details Data file is mapped read-only, and a record is parsed from its @n
+///          byte offset when its text is asked. Last CACHE records stay @n
+///          parsed, least recently used one is replaced. A returned string @n
+///          is valid until CACHE other records are read or file is remapped, @n
+///          so it is printed or copied right away. Pager is used by one @n
+///          thread.
+///
+
+class DeckPager
+{
+public:
+  static const int CACHE = 64;  ///< records kept parsed
+
+private:
+  struct Entry
+  {
+    unsigned long long offset;  ///< record offset in data file
+    char *mean;                 ///< meaning (owned), NULL if slot is empty
+    char *explain;              ///< explanation (owned)
+    unsigned long used;         ///< clock of last use
+  };
+
+  char *base;                   ///< mapped data file, NULL if not mapped
+  unsigned long length;         ///< bytes of mapping
+  Entry entry[CACHE];           ///< parsed records
+  int recent;                   ///< entry used last
+  unsigned long clock;          ///< use counter
+  unsigned long hits;           ///< requests answered from cache
+  unsigned long misses;         ///< requests which parsed record
+
+  /// @brief copying field which ends at '%' or '$'
+  ///
+  /// @param p position of field, advanced past its delimiter
+  /// @retval new string, NULL if field runs past mapping
+  char* copyField(unsigned long &p);
+
+  /// @brief finding or parsing record
+  ///
+  /// @param offset record offset in data file
+  /// @retval cache entry, NULL if offset is not a record
+  Entry* fetch(unsigned long long offset);
+
+  /// @brief freeing every cache entry
+  void drop(void);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having data file name
+  ///
+  /// @param file data file name
+  DeckPager(char* file);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~DeckPager(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief checking whether data file is mapped
+  bool isOpen(void) const;
+
+  /// @brief getting the number of requests answered from cache
+  unsigned long getHits(void) const;
+
+  /// @brief getting the number of requests which parsed record
+  unsigned long getMisses(void) const;
+
+  /// @brief getting bytes of parsed records, mapping is not counted
+  unsigned long getBytes(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief getting meaning of record
+  ///
+  /// @param offset record offset in data file
+  /// @retval meaning string, empty if record is broken
+  char* getMean(unsigned long long offset);
+
+  /// @brief getting explanation of record
+  ///
+  /// @param offset record offset in data file
+  /// @retval explanation string, empty if record is broken
+  char* getExplain(unsigned long long offset);
+
+  /// @brief mapping data file again after it was rewritten
+  /// @details On failure previous mapping is kept.
+  ///
+  /// @param file data file name
+  /// @retval true if mapped
+  bool remap(char* file);
+  /// @}
+};
+
+#endif /* __PAGER__ */
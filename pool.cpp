@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file pool.cpp
+/// @brief Work Pool Source File
+/// @details Reusable work stealing thread pool
+///
+/// @section purpose_section Purpose
+/// Splitting full scans over threads without creating threads per scan
+///
+
+#include <unistd.h>
+#include "pool.h"
+
+#ifndef NULL
+#define NULL 0
+#endif  /* NULL */
+
+/// @brief packing chunk range into one word
+static inline unsigned long long pack(unsigned int lo, unsigned int hi) {
+  return ((unsigned long long)lo << 32) | hi;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief WorkPool class functions implementation
+///
+
+WorkPool::WorkPool(int n) : generation(0), running(0), stopping(false),
+  func(NULL), arg(NULL), size(0), chunk(1)
+{
+  threads = n;
+  if (threads <= 0)
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads <= 0)
+    threads = 1;
+  if (threads > MAX_THREADS)
+    threads = MAX_THREADS;
+
+  for (int t = 0; t < MAX_THREADS; t++)
+    range[t].bounds = 0;
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&start, NULL);
+  pthread_cond_init(&finish, NULL);
+
+  for (int t = 1; t < threads; t++) {
+    worker[t].pool = this;
+    worker[t].id = t;
+    if (pthread_create(&tid[t], NULL, main, &worker[t]) != 0) {
+      threads = t; // work with threads created so far
+      break;
+    }
+  }
+}
+
+WorkPool::~WorkPool(void)
+{
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_broadcast(&start);
+  pthread_mutex_unlock(&lock);
+
+  for (int t = 1; t < threads; t++)
+    pthread_join(tid[t], NULL);
+
+  pthread_cond_destroy(&finish);
+  pthread_cond_destroy(&start);
+  pthread_mutex_destroy(&lock);
+}
+
+int WorkPool::getThreads(void) const
+{
+  return threads;
+}
+
+void* WorkPool::main(void* arg)
+{
+  Worker *w = (Worker*)arg;
+  w->pool->loop(w->id);
+  return NULL;
+}
+
+void WorkPool::loop(int id)
+{
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (generation == seen && !stopping)
+      pthread_cond_wait(&start, &lock);
+    if (stopping)
+      break;
+    seen = generation;
+    pthread_mutex_unlock(&lock);
+
+    work(id);
+
+    pthread_mutex_lock(&lock);
+    if (--running == 0)
+      pthread_cond_signal(&finish);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+bool WorkPool::take(int id, unsigned int &c)
+{
+  while (true) {
+    unsigned long long old = range[id].bounds;
+    unsigned int lo = (unsigned int)(old >> 32);
+    unsigned int hi = (unsigned int)old;
+    if (lo >= hi)
+      return false;
+
+    if (__sync_bool_compare_and_swap(&range[id].bounds, old, pack(lo + 1, hi))) {
+      c = lo;
+      return true;
+    }
+  }
+}
+
+bool WorkPool::steal(int victim, unsigned int &c)
+{
+  while (true) {
+    unsigned long long old = range[victim].bounds;
+    unsigned int lo = (unsigned int)(old >> 32);
+    unsigned int hi = (unsigned int)old;
+    if (lo >= hi)
+      return false;
+
+    if (__sync_bool_compare_and_swap(&range[victim].bounds, old, pack(lo, hi - 1))) {
+      c = hi - 1;
+      return true;
+    }
+  }
+}
+
+void WorkPool::work(int id)
+{
+  unsigned int c;
+
+  while (true) {
+    bool found = take(id, c);
+
+    // own range is empty, steal from others starting at the next one
+    for (int k = 1; !found && k < threads; k++)
+      found = steal((id + k) % threads, c);
+    if (!found)
+      return;
+
+    unsigned int first = c * chunk;
+    unsigned int last = (first + chunk < size) ? first + chunk : size;
+    func(arg, id, first, last);
+  }
+}
+
+void WorkPool::run(unsigned int n, unsigned int c, Chunk f, void* a)
+{
+  if (n == 0)
+    return;
+  if (c == 0)
+    c = 1;
+
+  unsigned int chunks = (n + c - 1) / c;
+  if (threads == 1 || chunks == 1) {
+    f(a, 0, 0, n); // nothing to share
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  func = f;
+  arg = a;
+  size = n;
+  chunk = c;
+  for (int t = 0; t < threads; t++) {
+    unsigned int lo = (unsigned int)((unsigned long long)chunks * t / threads);
+    unsigned int hi = (unsigned int)((unsigned long long)chunks * (t + 1) / threads);
+    range[t].bounds = pack(lo, hi);
+  }
+  running = threads - 1;
+  generation++;
+  pthread_cond_broadcast(&start);
+  pthread_mutex_unlock(&lock);
+
+  work(0);
+
+  // threads may still be in last chunk
+  pthread_mutex_lock(&lock);
+  while (running > 0)
+    pthread_cond_wait(&finish, &lock);
+  pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file pool.h
+/// @brief Work Pool Header File
+/// @details Reusable thread pool which runs chunked loops with work stealing
+///
+/// @section purpose_section Purpose
+/// Splitting full scans over threads without creating threads per scan
+///
+
+#ifndef __POOL__
+#define __POOL__
+
+#include <pthread.h>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Work Stealing Pool Class
+/// @details Threads are created once and sleep between runs. A run splits @n
+///          [0, size) into chunks and gives each thread an even range of @n
+///          chunks. Owner takes chunks from the low end of its range and @n
+///          thieves take from the high end, both by compare-and-swap on one @n
+///          word which packs the range, so no lock is held while scanning. @n
+///          Calling thread works as thread 0. One run at a time.
+///
+
+class WorkPool
+{
+public:
+  static const int MAX_THREADS = 64;   ///< maximum threads including caller
+
+  /// @brief chunk function
+  ///
+  /// @param arg argument given to run
+  /// @param thread thread number, 0 to getThreads() - 1
+  /// @param first first index of chunk
+  /// @param last index after the chunk
+  typedef void (*Chunk)(void* arg, int thread, unsigned int first,
+                        unsigned int last);
+
+private:
+  /// @brief chunk range of one thread, cache line sized
+  struct Range
+  {
+    volatile unsigned long long bounds;  ///< low end << 32 | high end
+    char pad[64 - sizeof(unsigned long long)]; ///< one range per cache line
+  };
+
+  /// @brief thread argument
+  struct Worker
+  {
+    WorkPool *pool;             ///< owner pool
+    int id;                     ///< thread number
+  };
+
+  int threads;                  ///< the number of threads including caller
+  pthread_t tid[MAX_THREADS];   ///< created threads, from 1
+  Worker worker[MAX_THREADS];   ///< thread arguments
+  Range range[MAX_THREADS];     ///< chunk ranges
+  pthread_mutex_t lock;         ///< guarding run state
+  pthread_cond_t start;         ///< signaled when run starts
+  pthread_cond_t finish;        ///< signaled when a thread finishes run
+  unsigned long generation;     ///< run number
+  int running;                  ///< threads still working in run
+  bool stopping;                ///< true if threads should exit
+  Chunk func;                   ///< chunk function of run
+  void *arg;                    ///< argument of run
+  unsigned int size;            ///< index range of run
+  unsigned int chunk;           ///< indexes per chunk
+
+  /// @brief thread entry
+  ///
+  /// @param arg Worker argument
+  /// @retval always NULL
+  static void* main(void* arg);
+
+  /// @brief waiting for runs until pool stops
+  ///
+  /// @param id thread number
+  void loop(int id);
+
+  /// @brief taking chunks, own first and stolen next, until none is left
+  ///
+  /// @param id thread number
+  void work(int id);
+
+  /// @brief taking one chunk from low end of own range
+  ///
+  /// @param id thread number
+  /// @param c receiving chunk number
+  /// @retval true if taken
+  bool take(int id, unsigned int &c);
+
+  /// @brief taking one chunk from high end of other range
+  ///
+  /// @param victim thread number whose range is stolen
+  /// @param c receiving chunk number
+  /// @retval true if taken
+  bool steal(int victim, unsigned int &c);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having thread count
+  ///
+  /// @param n the number of threads including caller, 0 for online CPUs
+  WorkPool(int n);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor, joining threads
+  ~WorkPool(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of threads including caller
+  int getThreads(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief running chunk function over [0, n) and waiting for it
+  ///
+  /// @param n the number of indexes
+  /// @param c indexes per chunk
+  /// @param f chunk function
+  /// @param a argument of chunk function
+  void run(unsigned int n, unsigned int c, Chunk f, void* a);
+  /// @}
+};
+
+#endif /* __POOL__ */
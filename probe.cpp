@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file probe.cpp
+/// @brief Probe Source File
+/// @details Counters and latency histograms of hot paths
+///
+/// @section purpose_section Purpose
+/// Finding where time goes in a session
+///
+
+#include <cstdio>
+#include <ctime>
+#include "probe.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Probe class functions implementation
+///
+
+unsigned long long Probe::counter[COUNTERS];
+unsigned long long Probe::count[TIMERS];
+unsigned long long Probe::total[TIMERS];
+unsigned long long Probe::longest[TIMERS];
+unsigned long long Probe::bucket[TIMERS][BUCKETS];
+
+static const char *counterName[] = { "candidates", "rejections", "bytes",
+                                     "weights" };
+static const char *timerName[] = { "load", "save", "findsim", "strsim",
+                                   "select" };
+
+unsigned long long Probe::now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void Probe::add(int c, unsigned long long n)
+{
+  __sync_fetch_and_add(&counter[c], n);
+}
+
+void Probe::record(int t, unsigned long long ns)
+{
+  int b = 0;
+  while (b + 1 < BUCKETS && (ns >> (b + 1)) != 0)
+    b++;
+
+  __sync_fetch_and_add(&count[t], 1ULL);
+  __sync_fetch_and_add(&total[t], ns);
+  __sync_fetch_and_add(&bucket[t][b], 1ULL);
+
+  unsigned long long old = longest[t];
+  while (ns > old && !__sync_bool_compare_and_swap(&longest[t], old, ns))
+    old = longest[t];
+}
+
+unsigned long long Probe::percentile(int t, double ratio)
+{
+  unsigned long long n = count[t];
+  if (n == 0)
+    return 0;
+
+  unsigned long long want = (unsigned long long)(n * ratio);
+  unsigned long long seen = 0;
+  for (int b = 0; b < BUCKETS; b++) {
+    seen += bucket[t][b];
+    if (seen > want) { // bucket upper bound, never above maximum
+      unsigned long long bound = (b + 1 < BUCKETS) ? (1ULL << (b + 1)) : ~0ULL;
+      return (bound < longest[t]) ? bound : longest[t];
+    }
+  }
+
+  return longest[t];
+}
+
+void Probe::report(ostream* o, bool json)
+{
+  char line[160];
+
+  if (json) {
+    *o << "{\"enabled\": " << PROBE << ", \"counters\": {";
+    for (int c = 0; c < COUNTERS; c++)
+      *o << (c ? ", " : "") << "\"" << counterName[c] << "\": " << counter[c];
+    *o << "}, \"timers\": {";
+    for (int t = 0; t < TIMERS; t++) {
+      *o << (t ? ", " : "") << "\"" << timerName[t] << "\": {\"count\": "
+         << count[t] << ", \"total_ns\": " << total[t] << ", \"p50_ns\": "
+         << percentile(t, 0.5) << ", \"p99_ns\": " << percentile(t, 0.99)
+         << ", \"max_ns\": " << longest[t] << ", \"buckets\": [";
+      for (int b = 0; b < BUCKETS; b++)
+        *o << (b ? ", " : "") << bucket[t][b];
+      *o << "]}";
+    }
+    *o << "}}" << endl;
+    return;
+  }
+
+  if (!PROBE) {
+    *o << "#    PROBE DISABLED (build with make PROBE=1)" << endl;
+    return;
+  }
+
+  *o << "#" << endl;
+  for (int c = 0; c < COUNTERS; c++) {
+    snprintf(line, sizeof(line), "#    %-10s %14llu", counterName[c],
+             counter[c]);
+    *o << line << endl;
+  }
+  *o << "#" << endl;
+  snprintf(line, sizeof(line), "#    %-10s %10s %12s %10s %10s %10s", "timer",
+           "count", "total_ms", "p50_us", "p99_us", "max_us");
+  *o << line << endl;
+  for (int t = 0; t < TIMERS; t++) {
+    snprintf(line, sizeof(line),
+             "#    %-10s %10llu %12.3f %10.3f %10.3f %10.3f", timerName[t],
+             count[t], total[t] / 1e6, percentile(t, 0.5) / 1e3,
+             percentile(t, 0.99) / 1e3, longest[t] / 1e3);
+    *o << line << endl;
+  }
+  *o << "#" << endl;
+}
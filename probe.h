@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file probe.h
+/// @brief Probe Header File
+/// @details Counters and latency histograms of hot paths. They are @n
+///          compiled out unless PROBE is 1 ("make PROBE=1"), then every @n
+///          PROBE_ macro expands to nothing.
+///
+/// @section purpose_section Purpose
+/// Finding where time goes in a session
+///
+
+#ifndef __PROBE__
+#define __PROBE__
+
+#include <iostream>
+
+#ifndef PROBE
+#define PROBE 0
+#endif  /* PROBE */
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Probe Class
+/// @details Static counters and timers updated by atomic add, so server @n
+///          workers record without lock. Timer keeps count, sum and maximum @n
+///          of nanoseconds and a histogram of 64 buckets, bucket b holding @n
+///          samples in [2^b, 2^(b+1)) nanoseconds.
+///
+
+class Probe
+{
+public:
+  /// @name counters
+  /// @{
+  static const int CANDIDATES = 0;  ///< words scored by Strsim in scans
+  static const int REJECTIONS = 1;  ///< extra draws of Random rejection loop
+  static const int BYTES = 2;       ///< data file bytes parsed
+  static const int WEIGHTS = 3;     ///< level weight calculations
+  static const int COUNTERS = 4;    ///< the number of counters
+  /// @}
+
+  /// @name timers
+  /// @{
+  static const int LOAD = 0;        ///< engine constructor loading deck
+  static const int SAVE = 1;        ///< saveChange
+  static const int FINDSIM = 2;     ///< one similarity scan of deck
+  static const int STRSIM = 3;      ///< one Strsim call in scan
+  static const int SELECT = 4;      ///< selectVoca
+  static const int TIMERS = 5;      ///< the number of timers
+  /// @}
+
+  static const int BUCKETS = 64;    ///< histogram buckets
+
+private:
+  static unsigned long long counter[COUNTERS];  ///< counter values
+  static unsigned long long count[TIMERS];      ///< timer samples
+  static unsigned long long total[TIMERS];      ///< timer nanoseconds sum
+  static unsigned long long longest[TIMERS];    ///< timer maximum
+  static unsigned long long bucket[TIMERS][BUCKETS]; ///< timer histogram
+
+  /// @brief upper bound of nanoseconds under which ratio of samples fall
+  ///
+  /// @param t timer
+  /// @param ratio 0.5 for median
+  /// @retval bucket upper bound capped by maximum, 0 if no sample
+  static unsigned long long percentile(int t, double ratio);
+
+public:
+  /// @brief monotonic clock in nanoseconds
+  static unsigned long long now(void);
+
+  /// @brief adding to counter
+  static void add(int c, unsigned long long n);
+
+  /// @brief recording one sample of timer
+  ///
+  /// @param t timer
+  /// @param ns elapsed nanoseconds
+  static void record(int t, unsigned long long ns);
+
+  /// @brief writing every counter and timer
+  ///
+  /// @param o output stream
+  /// @param json JSON object if true, table of "#" lines otherwise
+  static void report(ostream* o, bool json);
+};
+
+#if PROBE
+#define PROBE_COUNT(c, n)   Probe::add(Probe::c, (n))
+#define PROBE_START(v)      unsigned long long v = Probe::now()
+#define PROBE_STOP(t, v)    Probe::record(Probe::t, Probe::now() - (v))
+#else
+#define PROBE_COUNT(c, n)
+#define PROBE_START(v)
+#define PROBE_STOP(t, v)
+#endif  /* PROBE */
+
+#endif /* __PROBE__ */
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file querycache.cpp
+/// @brief Query Cache Source File
+/// @details Least recently used cache from search query to its scan result
+///
+/// @section purpose_section Purpose
+/// Answering repeated searches without scanning whole deck again
+///
+
+#include "querycache.h"
+#include "strutil.h"
+
+#define FNV_OFFSET    14695981039346656037ULL
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief QueryCache class functions implementation
+///
+
+QueryCache::QueryCache(unsigned int c) : capacity(c), size(0), head(NULL),
+  tail(NULL), hits(0), misses(0), bytes(0)
+{
+  if (capacity == 0)
+    capacity = 1;
+
+  buckets = 16;
+  while (buckets < capacity * 2)
+    buckets *= 2;
+
+  bucket = new Entry*[buckets];
+  for (unsigned int b = 0; b < buckets; b++)
+    bucket[b] = NULL;
+}
+
+QueryCache::~QueryCache(void)
+{
+  clear();
+  delete[] bucket;
+}
+
+unsigned int QueryCache::getSize(void) const
+{
+  return size;
+}
+
+unsigned long QueryCache::getHits(void) const
+{
+  return hits;
+}
+
+unsigned long QueryCache::getMisses(void) const
+{
+  return misses;
+}
+
+unsigned long QueryCache::getBytes(void) const
+{
+  return buckets * sizeof(Entry*) + bytes;
+}
+
+unsigned long QueryCache::sizeOf(Entry* e)
+{
+  return sizeof(Entry) + Strlen(e->query) + 1 + e->similar.getBytes()
+    + e->score.getBytes();
+}
+
+QueryCache::Entry* QueryCache::lookup(char* query, unsigned long long h) const
+{
+  Entry *e = bucket[(unsigned int)h & (buckets - 1)];
+
+  while (e && (e->hash != h || !Strequal(e->query, query)))
+    e = e->chain;
+
+  return e;
+}
+
+void QueryCache::detach(Entry* e)
+{
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    head = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+  else
+    tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+void QueryCache::pushFront(Entry* e)
+{
+  e->prev = NULL;
+  e->next = head;
+  if (head)
+    head->prev = e;
+  head = e;
+  if (!tail)
+    tail = e;
+}
+
+void QueryCache::drop(Entry* e)
+{
+  Entry **link = &bucket[(unsigned int)e->hash & (buckets - 1)];
+  while (*link != e)
+    link = &(*link)->chain;
+  *link = e->chain;
+
+  detach(e);
+  bytes -= sizeOf(e);
+  delete[] e->query;
+  delete(e);
+  size--;
+}
+
+bool QueryCache::find(char* query, unsigned long generation, int &match,
+                      Array <int> *similar, Array <int> *score)
+{
+  Entry *e = lookup(query, Strhash(query, FNV_OFFSET));
+
+  if (e && e->generation != generation) {
+    drop(e); // deck changed since this scan
+    e = NULL;
+  }
+  if (!e) {
+    misses++;
+    return false;
+  }
+
+  detach(e);
+  pushFront(e);
+  hits++;
+
+  match = e->match;
+  for (unsigned int k = 0; k < e->similar.getSize(); k++) {
+    similar->add(e->similar.get(k));
+    score->add(e->score.get(k));
+  }
+
+  return true;
+}
+
+void QueryCache::store(char* query, unsigned long generation, int match,
+                       Array <int> *similar, Array <int> *score)
+{
+  unsigned long long h = Strhash(query, FNV_OFFSET);
+  Entry *e = lookup(query, h);
+  if (e)
+    drop(e);
+
+  if (size == capacity)
+    drop(tail);
+
+  e = new Entry();
+  e->query = new char[sizeof(char) * Strlen(query) + 1];
+  Strcpy(e->query, query);
+  e->hash = h;
+  e->generation = generation;
+  e->match = match;
+  for (unsigned int k = 0; k < similar->getSize(); k++) {
+    e->similar.add(similar->get(k));
+    e->score.add(score->get(k));
+  }
+
+  unsigned int b = (unsigned int)h & (buckets - 1);
+  e->chain = bucket[b];
+  bucket[b] = e;
+  pushFront(e);
+  size++;
+  bytes += sizeOf(e);
+}
+
+void QueryCache::clear(void)
+{
+  while (head)
+    drop(head);
+}
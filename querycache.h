@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file querycache.h
+/// @brief Query Cache Header File
+/// @details Least recently used cache from search query to its scan result
+///
+/// @section purpose_section Purpose
+/// Answering repeated searches without scanning whole deck again
+///
+
+#ifndef __QUERYCACHE__
+#define __QUERYCACHE__
+
+#include "array.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Query Cache Class
+/// @details Entries are chained in buckets by FNV-1a hash of query and @n
+///          linked in a least recently used list, so lookup, store and @n
+///          eviction are O(1). Each entry keeps deck generation of its scan; @n
+///          an entry of older generation is dropped when it is looked up.
+///
+
+class QueryCache
+{
+private:
+  /// @brief cached scan result
+  struct Entry
+  {
+    char *query;                ///< query string (owned)
+    unsigned long long hash;    ///< hash of query
+    unsigned long generation;   ///< deck generation of scan
+    int match;                  ///< index of same word, -1 if none
+    Array <int> similar;        ///< similar indexes in scan order
+    Array <int> score;          ///< similarity of each similar index
+    Entry *chain;               ///< next entry in bucket
+    Entry *prev;                ///< more recently used entry
+    Entry *next;                ///< less recently used entry
+  };
+
+  Entry **bucket;               ///< bucket heads
+  unsigned int buckets;         ///< the number of buckets, power of two
+  unsigned int capacity;        ///< maximum entries
+  unsigned int size;            ///< the number of entries
+  Entry *head;                  ///< most recently used entry
+  Entry *tail;                  ///< least recently used entry
+  unsigned long hits;           ///< lookups answered from cache
+  unsigned long misses;         ///< lookups which need scan
+  unsigned long bytes;          ///< bytes of every entry
+
+  /// @brief finding entry of query
+  ///
+  /// @param query target query
+  /// @param h hash of target query
+  /// @retval entry, NULL if absent
+  Entry* lookup(char* query, unsigned long long h) const;
+
+  /// @brief unlinking entry from bucket and recently used list, freeing it
+  void drop(Entry* e);
+
+  /// @brief unlinking entry from recently used list
+  void detach(Entry* e);
+
+  /// @brief linking entry as most recently used
+  void pushFront(Entry* e);
+
+  /// @brief getting bytes of entry, its query and result arrays
+  static unsigned long sizeOf(Entry* e);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having capacity
+  ///
+  /// @param c maximum entries
+  QueryCache(unsigned int c);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~QueryCache(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of entries
+  unsigned int getSize(void) const;
+
+  /// @brief getting the number of lookups answered from cache
+  unsigned long getHits(void) const;
+
+  /// @brief getting the number of lookups which missed
+  unsigned long getMisses(void) const;
+
+  /// @brief getting bytes of buckets and entries
+  ///
+  /// @retval allocated bytes
+  unsigned long getBytes(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief finding scan result of query
+  ///
+  /// @param query target query
+  /// @param generation current deck generation
+  /// @param match receiving index of same word
+  /// @param similar array receiving similar indexes
+  /// @param score array receiving similarity of each similar index
+  /// @retval true if hit, false if absent or stale
+  bool find(char* query, unsigned long generation, int &match,
+            Array <int> *similar, Array <int> *score);
+
+  /// @brief storing scan result of query, evicting least recently used one
+  ///
+  /// @param query target query, which is copied
+  /// @param generation deck generation of scan
+  /// @param match index of same word
+  /// @param similar similar indexes
+  /// @param score similarity of each similar index
+  void store(char* query, unsigned long generation, int match,
+             Array <int> *similar, Array <int> *score);
+
+  /// @brief removing every entry, keeping counters
+  void clear(void);
+  /// @}
+};
+
+#endif /* __QUERYCACHE__ */
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file sampler.cpp
+/// @brief Weighted Sampler Source File
+/// @details Pseudo random generator and Fenwick tree based weighted sampler
+///
+/// @section purpose_section Purpose
+/// Selecting vocabulary without rejection loop
+///
+
+#include <ctime>
+#include "sampler.h"
+#include "probe.h"
+
+#ifndef NULL
+#define NULL 0
+#endif  /* NULL */
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Random class functions implementation
+///
+
+Random::Random(void)
+{
+  seed((unsigned long long)time(0));
+}
+
+Random::Random(unsigned long long s)
+{
+  seed(s);
+}
+
+void Random::seed(unsigned long long s)
+{
+  // splitmix64 step, spreading small seeds over every bit
+  unsigned long long z = s + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  state = z ^ (z >> 31);
+
+  if (state == 0) // xorshift never leaves zero state
+    state = 0x9E3779B97F4A7C15ULL;
+}
+
+unsigned long long Random::next(void)
+{
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+unsigned long long Random::below(unsigned long long bound)
+{
+  if (bound == 0)
+    return 0;
+
+  // reject top remainder so that every value has same probability
+  unsigned long long limit = ~0ULL - (~0ULL % bound);
+  unsigned long long r = next();
+  while (r >= limit) {
+    PROBE_COUNT(REJECTIONS, 1);
+    r = next();
+  }
+
+  return r % bound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Sampler class functions implementation
+///
+
+static inline unsigned int lowbit(unsigned int i) {
+  return i & (~i + 1);
+}
+
+Sampler::Sampler(Random *r) : tree(NULL), weight(NULL), size(0), capacity(0),
+  random(r)
+{
+}
+
+Sampler::~Sampler(void)
+{
+  if (tree)
+    delete[] tree;
+  if (weight)
+    delete[] weight;
+}
+
+bool Sampler::grow(unsigned int need)
+{
+  if (need <= capacity)
+    return true;
+
+  unsigned int newCap = (capacity == 0) ? 64 : capacity;
+  while (newCap < need)
+    newCap *= 2;
+
+  long long *newTree = new long long[newCap + 1];
+  int *newWeight = new int[newCap];
+  if (!newTree || !newWeight)
+    return false;
+
+  // tree node i only covers slots up to i, so old nodes stay valid
+  newTree[0] = 0;
+  for (unsigned int i = 1; i <= size; i++)
+    newTree[i] = tree[i];
+  for (unsigned int i = 0; i < size; i++)
+    newWeight[i] = weight[i];
+
+  if (tree)
+    delete[] tree;
+  if (weight)
+    delete[] weight;
+  tree = newTree;
+  weight = newWeight;
+  capacity = newCap;
+  return true;
+}
+
+unsigned int Sampler::getSize(void) const
+{
+  return size;
+}
+
+int Sampler::getWeight(unsigned int slot) const
+{
+  if (slot >= size)
+    return 0;
+
+  return weight[slot];
+}
+
+long long Sampler::getTotal(void) const
+{
+  long long sum = 0;
+  for (unsigned int i = size; i > 0; i -= lowbit(i))
+    sum += tree[i];
+
+  return sum;
+}
+
+unsigned long Sampler::getBytes(void) const
+{
+  if (capacity == 0)
+    return 0;
+
+  return (capacity + 1) * sizeof(long long) + capacity * sizeof(int);
+}
+
+bool Sampler::add(int w)
+{
+  if (w < 0)
+    w = 0;
+
+  if (!grow(size + 1))
+    return false;
+
+  weight[size] = w;
+  size++;
+
+  // new node covers (size - lowbit(size), size], gather its children
+  long long sum = w;
+  for (unsigned int j = size - 1; j > size - lowbit(size); j -= lowbit(j))
+    sum += tree[j];
+  tree[size] = sum;
+
+  return true;
+}
+
+bool Sampler::set(unsigned int slot, int w)
+{
+  if (slot >= size)
+    return false;
+
+  if (w < 0)
+    w = 0;
+
+  long long delta = w - weight[slot];
+  weight[slot] = w;
+
+  for (unsigned int i = slot + 1; i <= size; i += lowbit(i))
+    tree[i] += delta;
+
+  return true;
+}
+
+void Sampler::clear(void)
+{
+  size = 0;
+}
+
+int Sampler::sample(void)
+{
+  long long total = getTotal();
+  if (total <= 0)
+    return -1;
+
+  return find((long long)random->below((unsigned long long)total));
+}
+
+int Sampler::find(long long target) const
+{
+  if (target < 0 || target >= getTotal())
+    return -1;
+
+  // descend the tree, finding first slot whose prefix sum exceeds target
+  unsigned int step = 1;
+  while ((step << 1) <= size)
+    step <<= 1;
+
+  unsigned int pos = 0;
+  for (; step > 0; step >>= 1) {
+    if (pos + step <= size && tree[pos + step] <= target) {
+      pos += step;
+      target -= tree[pos];
+    }
+  }
+
+  return (int)pos; // 1-based pos + 1 is the slot, so 0-based slot is pos
+}
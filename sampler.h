@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file sampler.h
+/// @brief Weighted Sampler Header File
+/// @details Pseudo random generator and Fenwick tree based weighted sampler @n
+///          which is used for choosing test vocabulary.
+///
+/// @section purpose_section Purpose
+/// Selecting vocabulary without rejection loop
+///
+
+#ifndef __SAMPLER__
+#define __SAMPLER__
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Pseudo Random Number Generator Class
+/// @details xorshift64* generator. It is seeded only once at construction, @n
+///          so consecutive draws within the same second are all different.
+///
+
+class Random
+{
+private:
+  unsigned long long state;   ///< generator state, never zero
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  /// @details Seeding with current time
+  Random(void);
+
+  /// @brief constructor having seed
+  /// @details Defined for reproducible sequence
+  /// @param s seed value
+  Random(unsigned long long s);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief resetting generator with new seed
+  ///
+  /// @param s seed value
+  void seed(unsigned long long s);
+
+  /// @brief getting next 64-bit random number
+  ///
+  /// @retval random number
+  unsigned long long next(void);
+
+  /// @brief getting random number in [0, bound)
+  ///
+  /// @param bound exclusive upper bound, should be positive
+  /// @retval random number lower than bound
+  unsigned long long below(unsigned long long bound);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Weighted Sampler Class
+/// @details Each slot has non-negative integer weight, and slots are kept in @n
+///          a Fenwick tree (binary indexed tree) of prefix sums. Drawing one @n
+///          slot, appending one slot and changing one weight are O(log n).
+///
+
+class Sampler
+{
+private:
+  long long *tree;            ///< Fenwick tree, 1-based
+  int *weight;                ///< slot weights, 0-based
+  unsigned int size;          ///< the number of slots
+  unsigned int capacity;      ///< the number of allocated slots
+  Random *random;             ///< random generator (not owned)
+
+  /// @brief growing buffers to hold at least need slots
+  ///
+  /// @param need required capacity
+  /// @retval true if success, false if fail
+  bool grow(unsigned int need);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having random generator
+  ///
+  /// @param r random generator which is used for drawing
+  Sampler(Random *r);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~Sampler(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of slots
+  ///
+  /// @retval the number of slots
+  unsigned int getSize(void) const;
+
+  /// @brief getting slot weight
+  ///
+  /// @param slot slot index
+  /// @retval slot weight, 0 if slot is out of range
+  int getWeight(unsigned int slot) const;
+
+  /// @brief getting sum of all weights
+  ///
+  /// @retval total weight
+  long long getTotal(void) const;
+
+  /// @brief getting bytes of buffers
+  ///
+  /// @retval allocated bytes
+  unsigned long getBytes(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief appending new slot
+  ///
+  /// @param w weight of new slot
+  /// @retval true if success, false if fail
+  bool add(int w);
+
+  /// @brief changing weight of slot
+  ///
+  /// @param slot slot index
+  /// @param w new weight
+  /// @retval true if success, false if slot is out of range
+  bool set(unsigned int slot, int w);
+
+  /// @brief removing all slots
+  void clear(void);
+
+  /// @brief drawing one slot with probability proportional to its weight
+  ///
+  /// @retval slot index, -1 if there is no positive weight
+  int sample(void);
+
+  /// @brief finding first slot whose prefix sum exceeds target, O(log n)
+  /// @details With weights of 0 or 1, it is the slot of rank target.
+  ///
+  /// @param target value in [0, total)
+  /// @retval slot index, -1 if target is out of range
+  int find(long long target) const;
+  /// @}
+};
+
+#endif /* __SAMPLER__ */
@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file scheduler.cpp
+/// @brief Review Scheduler Source File
+/// @details Indexed binary min-heap of next-due times
+///
+/// @section purpose_section Purpose
+/// Spaced repetition for vocabulary test
+///
+
+#include "scheduler.h"
+
+#ifndef NULL
+#define NULL 0
+#endif  /* NULL */
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Scheduler class functions implementation
+///
+
+Scheduler::Scheduler(void) : heap(NULL), pos(NULL), due(NULL), size(0),
+  capacity(0), horizon(0), backlog(0)
+{
+}
+
+Scheduler::~Scheduler(void)
+{
+  if (heap)
+    delete[] heap;
+  if (pos)
+    delete[] pos;
+  if (due)
+    delete[] due;
+}
+
+bool Scheduler::grow(unsigned int need)
+{
+  if (need <= capacity)
+    return true;
+
+  unsigned int newCap = (capacity == 0) ? 64 : capacity;
+  while (newCap < need)
+    newCap *= 2;
+
+  unsigned int *newHeap = new unsigned int[newCap];
+  unsigned int *newPos = new unsigned int[newCap];
+  long *newDue = new long[newCap];
+  if (!newHeap || !newPos || !newDue)
+    return false;
+
+  for (unsigned int i = 0; i < size; i++) {
+    newHeap[i] = heap[i];
+    newPos[i] = pos[i];
+    newDue[i] = due[i];
+  }
+
+  if (heap)
+    delete[] heap;
+  if (pos)
+    delete[] pos;
+  if (due)
+    delete[] due;
+  heap = newHeap;
+  pos = newPos;
+  due = newDue;
+  capacity = newCap;
+  return true;
+}
+
+void Scheduler::swap(unsigned int a, unsigned int b)
+{
+  unsigned int tmp = heap[a];
+  heap[a] = heap[b];
+  heap[b] = tmp;
+
+  pos[heap[a]] = a;
+  pos[heap[b]] = b;
+}
+
+void Scheduler::siftUp(unsigned int p)
+{
+  while (p > 0) {
+    unsigned int parent = (p - 1) / 2;
+    if (due[heap[parent]] <= due[heap[p]])
+      break;
+    swap(parent, p);
+    p = parent;
+  }
+}
+
+void Scheduler::siftDown(unsigned int p)
+{
+  while (true) {
+    unsigned int least = p;
+    unsigned int left = 2 * p + 1;
+    unsigned int right = 2 * p + 2;
+
+    if (left < size && due[heap[left]] < due[heap[least]])
+      least = left;
+    if (right < size && due[heap[right]] < due[heap[least]])
+      least = right;
+
+    if (least == p)
+      break;
+    swap(least, p);
+    p = least;
+  }
+}
+
+unsigned int Scheduler::getSize(void) const
+{
+  return size;
+}
+
+int Scheduler::top(void) const
+{
+  if (size == 0)
+    return -1;
+
+  return (int)heap[0];
+}
+
+long Scheduler::getDue(unsigned int slot) const
+{
+  if (slot >= size)
+    return 0;
+
+  return due[slot];
+}
+
+long Scheduler::getHorizon(void) const
+{
+  return horizon;
+}
+
+unsigned int Scheduler::getBacklog(void) const
+{
+  return backlog;
+}
+
+unsigned long Scheduler::getBytes(void) const
+{
+  return capacity * (2 * sizeof(unsigned int) + sizeof(long));
+}
+
+bool Scheduler::add(long d)
+{
+  if (!grow(size + 1))
+    return false;
+
+  due[size] = d;
+  heap[size] = size;
+  pos[size] = size;
+  size++;
+  siftUp(size - 1);
+
+  if (d < horizon)
+    backlog++;
+
+  return true;
+}
+
+bool Scheduler::set(unsigned int slot, long d)
+{
+  if (slot >= size)
+    return false;
+
+  long old = due[slot];
+  due[slot] = d;
+
+  if (old < horizon && d >= horizon)
+    backlog--;
+  else if (old >= horizon && d < horizon)
+    backlog++;
+
+  if (d < old)
+    siftUp(pos[slot]);
+  else
+    siftDown(pos[slot]);
+
+  return true;
+}
+
+void Scheduler::clear(void)
+{
+  size = 0;
+  backlog = 0;
+}
+
+void Scheduler::setHorizon(long h)
+{
+  horizon = h;
+  backlog = 0;
+  for (unsigned int i = 0; i < size; i++) {
+    if (due[i] < horizon)
+      backlog++;
+  }
+}
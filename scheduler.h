@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file scheduler.h
+/// @brief Review Scheduler Header File
+/// @details Indexed binary min-heap ordering vocabulary slots by next-due @n
+///          time, with incrementally maintained backlog count.
+///
+/// @section purpose_section Purpose
+/// Spaced repetition for vocabulary test
+///
+
+#ifndef __SCHEDULER__
+#define __SCHEDULER__
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Due-Time Priority Queue Class
+/// @details Every slot holds one due time. The earliest due slot sits on top @n
+///          of the heap, and each slot remembers its heap position, so @n
+///          adding a slot, changing a due time and fetching the earliest @n
+///          slot are O(log n). @n
+///          Backlog (slots due before horizon) is adjusted on every change, @n
+///          and fully recounted only when horizon moves.
+///
+
+class Scheduler
+{
+private:
+  unsigned int *heap;         ///< heap position -> slot
+  unsigned int *pos;          ///< slot -> heap position
+  long *due;                  ///< slot -> due time
+  unsigned int size;          ///< the number of slots
+  unsigned int capacity;      ///< the number of allocated slots
+  long horizon;               ///< backlog counts slots due before horizon
+  unsigned int backlog;       ///< the number of slots due before horizon
+
+  /// @brief growing buffers to hold at least need slots
+  ///
+  /// @param need required capacity
+  /// @retval true if success, false if fail
+  bool grow(unsigned int need);
+
+  /// @brief swapping two heap positions
+  void swap(unsigned int a, unsigned int b);
+
+  /// @brief moving heap position toward root while it is earlier
+  void siftUp(unsigned int p);
+
+  /// @brief moving heap position toward leaf while it is later
+  void siftDown(unsigned int p);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  Scheduler(void);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~Scheduler(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of slots
+  ///
+  /// @retval the number of slots
+  unsigned int getSize(void) const;
+
+  /// @brief getting the earliest due slot
+  ///
+  /// @retval slot index, -1 if empty
+  int top(void) const;
+
+  /// @brief getting due time of slot
+  ///
+  /// @param slot slot index
+  /// @retval due time, 0 if slot is out of range
+  long getDue(unsigned int slot) const;
+
+  /// @brief getting backlog horizon
+  ///
+  /// @retval horizon time
+  long getHorizon(void) const;
+
+  /// @brief getting the number of slots due before horizon
+  ///
+  /// @retval backlog count
+  unsigned int getBacklog(void) const;
+
+  /// @brief getting bytes of buffers
+  ///
+  /// @retval allocated bytes
+  unsigned long getBytes(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief appending new slot
+  ///
+  /// @param d due time of new slot
+  /// @retval true if success, false if fail
+  bool add(long d);
+
+  /// @brief changing due time of slot
+  ///
+  /// @param slot slot index
+  /// @param d new due time
+  /// @retval true if success, false if slot is out of range
+  bool set(unsigned int slot, long d);
+
+  /// @brief removing all slots
+  void clear(void);
+
+  /// @brief moving backlog horizon and recounting backlog in O(n)
+  ///
+  /// @param h new horizon time
+  void setHorizon(long h);
+  /// @}
+};
+
+#endif /* __SCHEDULER__ */
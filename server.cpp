@@ -0,0 +1,604 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file server.cpp
+/// @brief Deck Server Source File
+/// @details Unix domain socket server with epoll event loop and worker pool
+///
+/// @section purpose_section Purpose
+/// Sharing one deck among concurrent clients
+///
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <ctime>
+#include <sstream>
+#include "server.h"
+#include "strutil.h"
+#include "probe.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief VocaServer class functions implementation
+///
+
+int VocaServer::wakeWrite = -1;
+
+VocaServer::VocaServer(VocaEngine* e, char* p, int w) : engine(e),
+  listenFd(-1), epollFd(-1), workerCount(w), workers(NULL),
+  pendingHead(NULL), pendingTail(NULL), doneHead(NULL), doneTail(NULL),
+  stopping(false), served(0), saveDue(0)
+{
+  path = new char[sizeof(char) * Strlen(p) + 1];
+  Strcpy(path, p);
+  wakeFd[0] = wakeFd[1] = -1;
+
+  if (workerCount <= 0)
+    workerCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (workerCount <= 0)
+    workerCount = 1;
+
+  clients = new Array<Connection*>();
+  closed = new Array<Connection*>();
+  pthread_mutex_init(&writeLock, NULL);
+  pthread_mutex_init(&queueLock, NULL);
+  pthread_cond_init(&queueCond, NULL);
+}
+
+VocaServer::~VocaServer(void)
+{
+  if (workers) {
+    pthread_mutex_lock(&queueLock);
+    stopping = true;
+    pthread_cond_broadcast(&queueCond);
+    pthread_mutex_unlock(&queueLock);
+
+    // workers finish queued requests before they exit
+    for (int t = 0; t < workerCount; t++)
+      pthread_join(workers[t], NULL);
+    delete[] workers;
+  }
+
+  while (doneHead) {
+    Job *job = doneHead;
+    doneHead = job->next;
+    if (job->line)
+      delete[] job->line;
+    delete[] job->reply;
+    delete(job);
+  }
+
+  for (unsigned int k = 0; k < clients->getSize(); k++) {
+    Connection *conn = clients->get(k);
+    if (conn->fd >= 0)
+      close(conn->fd);
+    delete[] conn->in;
+    if (conn->out)
+      delete[] conn->out;
+    delete(conn);
+  }
+  delete(clients);
+  delete(closed);
+
+  if (listenFd >= 0) {
+    close(listenFd);
+    unlink(path);
+  }
+  if (epollFd >= 0)
+    close(epollFd);
+  if (wakeFd[0] >= 0) {
+    wakeWrite = -1;
+    close(wakeFd[0]);
+    close(wakeFd[1]);
+  }
+
+  pthread_cond_destroy(&queueCond);
+  pthread_mutex_destroy(&queueLock);
+  pthread_mutex_destroy(&writeLock);
+  delete[] path;
+}
+
+void VocaServer::onSignal(int sig)
+{
+  (void)sig;
+  if (wakeWrite >= 0) {
+    char c = 's';
+    if (write(wakeWrite, &c, 1) < 0) {} // nothing to do in handler
+  }
+}
+
+void* VocaServer::worker(void* arg)
+{
+  ((VocaServer*)arg)->work();
+  return NULL;
+}
+
+void VocaServer::work(void)
+{
+  // question selection of this worker, apart from other workers
+  Random random((unsigned long long)time(0) ^ (unsigned long long)pthread_self());
+
+  while (true) {
+    pthread_mutex_lock(&queueLock);
+    while (!pendingHead && !stopping)
+      pthread_cond_wait(&queueCond, &queueLock);
+    if (!pendingHead) { // stopping and drained
+      pthread_mutex_unlock(&queueLock);
+      break;
+    }
+    Job *job = pendingHead;
+    pendingHead = job->next;
+    if (!pendingHead)
+      pendingTail = NULL;
+    pthread_mutex_unlock(&queueLock);
+
+    ostringstream reply;
+    if (job->line) {
+      job->quit = !execute(job->line, &reply, &random, job->changed);
+    } else {
+      pthread_mutex_lock(&writeLock);
+      engine->cmdSave(&reply); // periodic save
+      job->changed = engine->isDirty(); // failed, tried again later
+      pthread_mutex_unlock(&writeLock);
+    }
+    reply << ".\n";
+
+    string text = reply.str();
+    job->replyLen = text.size();
+    job->reply = new char[job->replyLen + 1];
+    for (unsigned int k = 0; k < job->replyLen; k++)
+      job->reply[k] = text[k];
+    job->next = NULL;
+
+    pthread_mutex_lock(&queueLock);
+    if (doneTail)
+      doneTail->next = job;
+    else
+      doneHead = job;
+    doneTail = job;
+    pthread_mutex_unlock(&queueLock);
+
+    char c = 'j';
+    if (write(wakeFd[1], &c, 1) < 0) {} // pipe full still wakes event loop
+  }
+}
+
+bool VocaServer::execute(char* line, ostream* o, Random* r, bool &changed)
+{
+  char *arg[5];
+  int n = 0;
+
+  // split fields in place
+  arg[n++] = line;
+  for (int k = 0; line[k] != '\0' && n < 5; k++) {
+    if (line[k] == '\t') {
+      line[k] = '\0';
+      arg[n++] = line + k + 1;
+    }
+  }
+
+  // reads run on snapshot without lock, writes one at a time
+  if (Strequal(arg[0], (char*)"search") && n == 2) {
+    engine->cmdSearch(arg[1], o);
+  } else if (Strequal(arg[0], (char*)"list") && n <= 2) {
+    if (!engine->cmdList(n == 2 ? (int)StrToInt(arg[1]) : 1, o))
+      *o << "none\n";
+  } else if (Strequal(arg[0], (char*)"stats") && n == 1) {
+    engine->cmdStats(o);
+    pthread_mutex_lock(&writeLock); // memory accounts are writer's
+    engine->cmdMemory(o);
+    pthread_mutex_unlock(&writeLock);
+  } else if (Strequal(arg[0], (char*)"next") && n == 1) {
+    engine->cmdNext(o, r);
+  } else if (Strequal(arg[0], (char*)"add") && n == 4) {
+    pthread_mutex_lock(&writeLock);
+    engine->cmdAdd(arg[1], arg[2], arg[3], o);
+    changed = engine->isDirty();
+    pthread_mutex_unlock(&writeLock);
+  } else if (Strequal(arg[0], (char*)"delete") && n >= 2) {
+    pthread_mutex_lock(&writeLock);
+    engine->cmdDelete(arg + 1, n - 1, o);
+    changed = engine->isDirty();
+    pthread_mutex_unlock(&writeLock);
+  } else if (Strequal(arg[0], (char*)"score") && n == 3) {
+    pthread_mutex_lock(&writeLock);
+    engine->cmdScore(arg[1], Strequal(arg[2], (char*)"1"), o);
+    changed = engine->isDirty();
+    pthread_mutex_unlock(&writeLock);
+  } else if (Strequal(arg[0], (char*)"save") && n == 1) {
+    pthread_mutex_lock(&writeLock);
+    engine->cmdSave(o);
+    pthread_mutex_unlock(&writeLock);
+  } else if (Strequal(arg[0], (char*)"probe") && n <= 2) {
+    Probe::report(o, n == 2 && Strequal(arg[1], (char*)"json"));
+  } else if (Strequal(arg[0], (char*)"quit") && n == 1) {
+    *o << "bye\n";
+    return false;
+  } else {
+    *o << "error\tunknown request\t" << arg[0] << "\n";
+  }
+
+  return true;
+}
+
+void VocaServer::submit(Connection* conn, char* line)
+{
+  Job *job = new Job();
+  job->conn = conn;
+  job->line = line;
+  job->reply = NULL;
+  job->replyLen = 0;
+  job->quit = false;
+  job->changed = false;
+  job->next = NULL;
+
+  pthread_mutex_lock(&queueLock);
+  if (pendingTail)
+    pendingTail->next = job;
+  else
+    pendingHead = job;
+  pendingTail = job;
+  pthread_cond_signal(&queueCond);
+  pthread_mutex_unlock(&queueLock);
+}
+
+void VocaServer::acceptClients(void)
+{
+  while (true) {
+    int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+      return; // EAGAIN, or client gave up
+
+    Connection *conn = new Connection();
+    conn->fd = fd;
+    conn->in = new char[MAX_LINE];
+    conn->inLen = 0;
+    conn->out = NULL;
+    conn->outLen = conn->outCap = conn->outPos = 0;
+    conn->events = EPOLLIN;
+    conn->slot = clients->getSize();
+    conn->busy = false;
+    conn->quitting = false;
+
+    struct epoll_event ev;
+    ev.events = conn->events;
+    ev.data.ptr = conn;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0 || !clients->add(conn)) {
+      close(fd);
+      delete[] conn->in;
+      delete(conn);
+    }
+  }
+}
+
+void VocaServer::readClient(Connection* conn)
+{
+  while (conn->inLen < MAX_LINE) {
+    ssize_t n = recv(conn->fd, conn->in + conn->inLen, MAX_LINE - conn->inLen, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+      closeClient(conn); // client left
+      return;
+    }
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    conn->inLen += n;
+  }
+
+  dispatch(conn);
+  watch(conn);
+}
+
+void VocaServer::dispatch(Connection* conn)
+{
+  if (conn->busy || conn->quitting || conn->fd < 0)
+    return;
+
+  unsigned int end = 0;
+  while (end < conn->inLen && conn->in[end] != '\n')
+    end++;
+
+  if (end == conn->inLen) {
+    if (conn->inLen < MAX_LINE)
+      return; // line is not complete yet
+
+    char *error = (char*)"error\trequest too long\n.\n";
+    conn->inLen = 0;
+    conn->quitting = true;
+    append(conn, error, Strlen(error));
+    writeClient(conn);
+    return;
+  }
+
+  unsigned int len = end;
+  if (len > 0 && conn->in[len - 1] == '\r')
+    len--;
+
+  char *line = new char[len + 1];
+  for (unsigned int k = 0; k < len; k++)
+    line[k] = conn->in[k];
+  line[len] = '\0';
+
+  // keep bytes after the line for next request
+  for (unsigned int k = end + 1; k < conn->inLen; k++)
+    conn->in[k - end - 1] = conn->in[k];
+  conn->inLen -= end + 1;
+
+  conn->busy = true;
+  submit(conn, line);
+}
+
+void VocaServer::append(Connection* conn, char* data, unsigned int len)
+{
+  if (conn->outLen + len > conn->outCap) {
+    unsigned int cap = (conn->outCap == 0) ? 256 : conn->outCap;
+    while (cap < conn->outLen + len)
+      cap *= 2;
+
+    char *buf = new char[cap];
+    for (unsigned int k = 0; k < conn->outLen; k++)
+      buf[k] = conn->out[k];
+    if (conn->out)
+      delete[] conn->out;
+    conn->out = buf;
+    conn->outCap = cap;
+  }
+
+  for (unsigned int k = 0; k < len; k++)
+    conn->out[conn->outLen++] = data[k];
+}
+
+void VocaServer::writeClient(Connection* conn)
+{
+  while (conn->outPos < conn->outLen) {
+    ssize_t n = send(conn->fd, conn->out + conn->outPos,
+                     conn->outLen - conn->outPos, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN)
+        break;
+      closeClient(conn);
+      return;
+    }
+    conn->outPos += n;
+  }
+
+  if (conn->outPos < conn->outLen) {
+    watch(conn);
+    return;
+  }
+
+  conn->outPos = conn->outLen = 0;
+  if (conn->quitting && !conn->busy)
+    closeClient(conn);
+  else
+    watch(conn);
+}
+
+void VocaServer::watch(Connection* conn)
+{
+  if (conn->fd < 0)
+    return;
+
+  unsigned int events = 0;
+  if (conn->inLen < MAX_LINE && !conn->quitting)
+    events |= EPOLLIN;
+  if (conn->outPos < conn->outLen)
+    events |= EPOLLOUT;
+
+  if (events == conn->events)
+    return;
+
+  struct epoll_event ev;
+  ev.events = events;
+  ev.data.ptr = conn;
+  epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+  conn->events = events;
+}
+
+void VocaServer::collect(void)
+{
+  pthread_mutex_lock(&queueLock);
+  Job *job = doneHead;
+  doneHead = doneTail = NULL;
+  pthread_mutex_unlock(&queueLock);
+
+  while (job) {
+    Job *next = job->next;
+    Connection *conn = job->conn;
+
+    if (job->changed && saveDue == 0)
+      saveDue = time(0) + SAVE_PERIOD;
+
+    if (conn) {
+      conn->busy = false;
+      served++;
+
+      if (conn->fd < 0) {
+        closed->add(conn); // client left while request was in workers
+      } else {
+        append(conn, job->reply, job->replyLen);
+        if (job->quit)
+          conn->quitting = true;
+
+        dispatch(conn); // next pipelined request runs while reply is sent
+        writeClient(conn);
+      }
+    }
+
+    if (job->line)
+      delete[] job->line;
+    delete[] job->reply;
+    delete(job);
+    job = next;
+  }
+}
+
+void VocaServer::closeClient(Connection* conn)
+{
+  if (conn->fd < 0)
+    return;
+
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, NULL);
+  close(conn->fd);
+  conn->fd = -1;
+
+  if (!conn->busy)
+    closed->add(conn);
+}
+
+void VocaServer::freeClient(Connection* conn)
+{
+  // move last connection into the hole
+  Connection *last = clients->get(clients->getSize() - 1);
+  clients->set(conn->slot, last);
+  last->slot = conn->slot;
+  clients->remove(clients->getSize() - 1);
+
+  delete[] conn->in;
+  if (conn->out)
+    delete[] conn->out;
+  delete(conn);
+}
+
+bool VocaServer::start(void)
+{
+  struct sockaddr_un addr;
+  if (Strlen(path) >= (int)sizeof(addr.sun_path)) {
+    cout << "error\tsocket path too long\t" << path << endl;
+    return false;
+  }
+  addr.sun_family = AF_UNIX;
+  Strcpy(addr.sun_path, path);
+
+  listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd < 0) {
+    cout << "error\tcannot create socket" << endl;
+    return false;
+  }
+
+  // leftover socket file of a dead server is replaced, live one is not
+  int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+  bool alive = (probe >= 0 &&
+                connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+  if (probe >= 0)
+    close(probe);
+  if (alive) {
+    cout << "error\tserver already running\t" << path << endl;
+    close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+  unlink(path);
+
+  if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+      listen(listenFd, SOMAXCONN) < 0) {
+    cout << "error\tcannot bind\t" << path << endl;
+    close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+
+  if (pipe(wakeFd) < 0) {
+    cout << "error\tcannot create pipe" << endl;
+    return false;
+  }
+  fcntl(wakeFd[0], F_SETFL, O_NONBLOCK);
+  fcntl(wakeFd[1], F_SETFL, O_NONBLOCK);
+
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = &listenFd;
+  if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) < 0) {
+    cout << "error\tcannot create epoll" << endl;
+    return false;
+  }
+  ev.data.ptr = &wakeFd[0];
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd[0], &ev);
+
+  wakeWrite = wakeFd[1];
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  workers = new pthread_t[workerCount];
+  for (int t = 0; t < workerCount; t++) {
+    if (pthread_create(&workers[t], NULL, worker, this) != 0) {
+      workerCount = t;
+      break;
+    }
+  }
+  if (workerCount == 0) {
+    cout << "error\tcannot create worker" << endl;
+    return false;
+  }
+
+  cout << "serving\t" << path << "\t" << workerCount << " workers" << endl;
+  return true;
+}
+
+void VocaServer::run(void)
+{
+  struct epoll_event events[MAX_EVENTS];
+  bool running = true;
+
+  if (engine->isDirty()) // e.g. deck read in other shard layout
+    saveDue = time(0) + SAVE_PERIOD;
+
+  while (running) {
+    int timeout = -1; // nothing to save, waiting for requests
+    if (saveDue != 0) {
+      time_t left = saveDue - time(0);
+      timeout = (left > 0) ? (int)left * 1000 : 0;
+    }
+
+    int n = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+    if (n < 0 && errno != EINTR)
+      break;
+    if (saveDue != 0 && time(0) >= saveDue) {
+      submit(NULL, NULL); // deadline passed, busy or not, save in background
+      saveDue = 0;
+    }
+
+    for (int k = 0; k < n; k++) {
+      void *ptr = events[k].data.ptr;
+
+      if (ptr == &listenFd) {
+        acceptClients();
+      } else if (ptr == &wakeFd[0]) {
+        char buf[64];
+        ssize_t got;
+        while ((got = read(wakeFd[0], buf, sizeof(buf))) > 0) {
+          for (ssize_t i = 0; i < got; i++) {
+            if (buf[i] == 's')
+              running = false;
+          }
+        }
+        collect();
+      } else {
+        Connection *conn = (Connection*)ptr;
+        if (conn->fd < 0)
+          continue; // closed earlier in this batch
+
+        if (events[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+          readClient(conn);
+        if (conn->fd >= 0 && (events[k].events & EPOLLOUT))
+          writeClient(conn);
+      }
+    }
+
+    for (unsigned int k = 0; k < closed->getSize(); k++)
+      freeClient(closed->get(k));
+    closed->clear();
+  }
+
+  cout << "stopped\t" << served << " requests" << endl;
+}
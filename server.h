@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file server.h
+/// @brief Deck Server Header File
+/// @details Unix domain socket server which serves one in-memory deck to @n
+///          many clients, so deck is parsed once and saved by one process.
+///
+/// @section purpose_section Purpose
+/// Sharing one deck among concurrent clients
+///
+/// @section protocol_section Protocol
+/// One request per line, fields separated by tab. @n
+/// search WORD / add WORD MEANING EXPLAIN / list [PAGE] / stats / next / @n
+/// score WORD 1|0 / delete WORD... (up to 4) / probe [json] / save / quit @n
+/// Reply lines are same as batch commands, and every reply ends with ".".
+///
+
+#ifndef __SERVER__
+#define __SERVER__
+
+#include <pthread.h>
+#include <ctime>
+#include <iostream>
+#include "VocaMaster.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Deck Server Class
+/// @details One event loop thread accepts clients and reads requests by @n
+///          epoll, and worker threads run requests against engine. Each @n
+///          connection has at most one request in workers, so replies keep @n
+///          request order. Finished replies come back to event loop through @n
+///          a queue and a wake pipe, and only event loop touches sockets. @n
+///          Read requests run on engine snapshots in parallel, and write @n
+///          requests run one at a time under write lock.
+///
+
+class VocaServer
+{
+private:
+  static const int MAX_EVENTS = 64;          ///< events per epoll wait
+  static const unsigned int MAX_LINE = 1024; ///< maximum request length
+  static const int SAVE_PERIOD = 60;         ///< seconds from change to save
+
+  /// @brief client connection state
+  struct Connection
+  {
+    int fd;                     ///< client socket, -1 if closed
+    char *in;                   ///< received bytes not yet requested
+    unsigned int inLen;         ///< the number of received bytes
+    char *out;                  ///< reply bytes not yet sent
+    unsigned int outLen;        ///< the number of reply bytes
+    unsigned int outCap;        ///< reply buffer size
+    unsigned int outPos;        ///< the number of sent reply bytes
+    unsigned int events;        ///< epoll events being watched
+    unsigned int slot;          ///< index in client array
+    bool busy;                  ///< true while request is in workers
+    bool quitting;              ///< true if closing after reply is sent
+  };
+
+  /// @brief request passed between event loop and workers
+  struct Job
+  {
+    Connection *conn;           ///< requesting connection, NULL for save
+    char *line;                 ///< request line
+    char *reply;                ///< reply bytes
+    unsigned int replyLen;      ///< the number of reply bytes
+    bool quit;                  ///< true if client asked to quit
+    bool changed;               ///< true if engine is left with unsaved changes
+    Job *next;                  ///< next job in queue
+  };
+
+  static int wakeWrite;         ///< wake pipe for signal handler
+
+  VocaEngine *engine;           ///< served engine (not owned)
+  char *path;                   ///< socket file path
+  int listenFd;                 ///< listening socket
+  int epollFd;                  ///< epoll instance
+  int wakeFd[2];                ///< wake pipe, read and write end
+  int workerCount;              ///< the number of worker threads
+  pthread_t *workers;           ///< worker threads
+  pthread_mutex_t writeLock;    ///< serializing engine writers
+  pthread_mutex_t queueLock;    ///< guarding both job queues
+  pthread_cond_t queueCond;     ///< signaled when job is queued
+  Job *pendingHead;             ///< jobs waiting for worker
+  Job *pendingTail;             ///< last job waiting for worker
+  Job *doneHead;                ///< jobs waiting for event loop
+  Job *doneTail;                ///< last job waiting for event loop
+  Array <Connection*> *clients; ///< open or busy connections
+  Array <Connection*> *closed;  ///< connections freed after event batch
+  bool stopping;                ///< true if workers should exit
+  unsigned long served;         ///< the number of replied requests
+  time_t saveDue;               ///< time to save changes, 0 if none is pending
+
+  /// @brief worker thread entry
+  ///
+  /// @param arg VocaServer instance
+  /// @retval always NULL
+  static void* worker(void* arg);
+
+  /// @brief taking jobs until server stops
+  void work(void);
+
+  /// @brief signal handler which wakes event loop for shutdown
+  static void onSignal(int sig);
+
+  /// @brief running one request line against engine
+  ///
+  /// @param line request line, split in place
+  /// @param o reply stream
+  /// @param r random generator of calling worker
+  /// @param changed set true if request may have changed engine
+  /// @retval false if client asked to quit
+  bool execute(char* line, ostream* o, Random* r, bool &changed);
+
+  /// @brief queueing job to workers
+  void submit(Connection* conn, char* line);
+
+  /// @brief accepting every waiting client
+  void acceptClients(void);
+
+  /// @brief reading bytes of client and dispatching a complete line
+  void readClient(Connection* conn);
+
+  /// @brief passing next complete line of idle client to workers
+  void dispatch(Connection* conn);
+
+  /// @brief appending bytes to reply buffer
+  ///
+  /// @param conn connection
+  /// @param data reply bytes
+  /// @param len the number of bytes
+  void append(Connection* conn, char* data, unsigned int len);
+
+  /// @brief sending reply bytes as many as socket takes
+  void writeClient(Connection* conn);
+
+  /// @brief watching events which connection state needs
+  void watch(Connection* conn);
+
+  /// @brief moving finished replies to their connections
+  /// @details Reply of change starts save deadline unless one is pending.
+  void collect(void);
+
+  /// @brief closing client socket
+  /// @details State is freed after event batch, or after its request @n
+  ///          comes back from workers if it is busy.
+  void closeClient(Connection* conn);
+
+  /// @brief freeing connection state
+  void freeClient(Connection* conn);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief constructor having engine and socket path
+  ///
+  /// @param e engine which will be served
+  /// @param p socket file path
+  /// @param w the number of worker threads, 0 for online CPUs
+  VocaServer(VocaEngine* e, char* p, int w);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details Removing socket file. Engine is saved by its owner.
+  ~VocaServer(void);
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief creating socket and worker threads
+  ///
+  /// @retval true if success, false if fail
+  bool start(void);
+
+  /// @brief running event loop until SIGINT or SIGTERM
+  void run(void);
+  /// @}
+};
+
+#endif /* __SERVER__ */
@@ -0,0 +1,481 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file snapshot.cpp
+/// @brief Snapshot Source File
+/// @details Epoch based reclamation and copy-on-write deck versions
+///
+/// @section purpose_section Purpose
+/// Reading deck from many threads while it is updated
+///
+
+#include <pthread.h>
+#include <sched.h>
+#include <climits>
+#include "snapshot.h"
+#include "VocaMaster.h"
+#include "strutil.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Epoch class functions implementation
+///
+
+Epoch::Epoch(void) : global(1), retired(NULL), pending(0)
+{
+  for (int k = 0; k < MAX_READERS; k++)
+    slot[k].epoch = 0;
+}
+
+Epoch::~Epoch(void)
+{
+  while (retired) {
+    Retired *r = retired;
+    retired = r->next;
+    r->release(r->ptr);
+    delete(r);
+  }
+}
+
+unsigned int Epoch::getPending(void) const
+{
+  return pending;
+}
+
+int Epoch::enter(void)
+{
+  // threads start at different slots, so they rarely race for one
+  unsigned long start = (unsigned long)pthread_self();
+  start = (start >> 12) ^ (start >> 20);
+
+  while (true) {
+    unsigned long e = global;
+    for (int k = 0; k < MAX_READERS; k++) {
+      int s = (int)((start + k) % MAX_READERS);
+      // full barrier, so loads of shared data come after slot is marked
+      if (slot[s].epoch == 0 &&
+          __sync_bool_compare_and_swap(&slot[s].epoch, 0UL, e))
+        return s;
+    }
+    sched_yield(); // every slot is used
+  }
+}
+
+void Epoch::exit(int ticket)
+{
+  __sync_synchronize(); // reads of shared data end before slot is cleared
+  slot[ticket].epoch = 0;
+}
+
+void Epoch::retire(void* ptr, Release release)
+{
+  Retired *r = new Retired();
+  r->ptr = ptr;
+  r->release = release;
+
+  // readers entering after this increment cannot reach ptr
+  __sync_synchronize();
+  r->epoch = __sync_fetch_and_add(&global, 1);
+  r->next = retired;
+  retired = r;
+  pending++;
+}
+
+void Epoch::reclaim(void)
+{
+  __sync_synchronize(); // publish is visible before slots are read
+
+  unsigned long oldest = ULONG_MAX;
+  for (int k = 0; k < MAX_READERS; k++) {
+    unsigned long e = slot[k].epoch;
+    if (e != 0 && e < oldest)
+      oldest = e;
+  }
+
+  // a reader which entered at epoch e may hold data retired at e or later
+  Retired **link = &retired;
+  while (*link) {
+    Retired *r = *link;
+    if (r->epoch < oldest) {
+      *link = r->next;
+      r->release(r->ptr);
+      delete(r);
+      pending--;
+    } else {
+      link = &r->next;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Snapshot class functions implementation
+///
+
+Snapshot::Snapshot(Snapshot* prev) : page(NULL), pages(0), capacity(0),
+  size(0), dead(0), version(0)
+{
+  if (!prev) {
+    for (int l = 0; l < DeckStats::LEVELS; l++)
+      stats.perLevel[l] = 0;
+    stats.expSum = 0;
+    stats.mastered = 0;
+    stats.horizon = 0;
+    stats.backlog = 0;
+    stats.answered = 0;
+    stats.correct = 0;
+    return;
+  }
+
+  stats = prev->stats;
+  pages = prev->pages;
+  size = prev->size;
+  dead = prev->dead;
+  version = prev->version + 1;
+  capacity = (pages == 0) ? 16 : pages;
+  page = new Page*[capacity];
+  for (unsigned int p = 0; p < pages; p++)
+    page[p] = prev->page[p];
+}
+
+Snapshot::~Snapshot(void)
+{
+  if (page)
+    delete[] page;
+}
+
+void Snapshot::summarize(Page* p)
+{
+  p->total = 0;
+  p->minDue = LONG_MAX;
+  p->minSlot = -1;
+
+  for (unsigned int k = 0; k < p->count; k++) {
+    p->total += p->weight[k];
+    if (!p->entry[k]->isDead() && p->entry[k]->getDue() < p->minDue) {
+      p->minDue = p->entry[k]->getDue();
+      p->minSlot = k;
+    }
+  }
+}
+
+void Snapshot::count(Voca* v, int sign)
+{
+  if (!v || v->isDead())
+    return;
+
+  int level = v->getLevel();
+  if (level >= 0 && level < DeckStats::LEVELS)
+    stats.perLevel[level] += sign;
+  stats.expSum += sign * v->getExp();
+  if (level == Voca::MAX_LEVEL && v->getExp() == 100)
+    stats.mastered += sign;
+  if (v->getDue() < stats.horizon)
+    stats.backlog += sign;
+}
+
+unsigned long Snapshot::getVersion(void) const
+{
+  return version;
+}
+
+unsigned int Snapshot::getSize(void) const
+{
+  return size;
+}
+
+unsigned int Snapshot::getLive(void) const
+{
+  return size - dead;
+}
+
+const DeckStats& Snapshot::getStats(void) const
+{
+  return stats;
+}
+
+unsigned long Snapshot::bytesOf(unsigned int entries)
+{
+  unsigned int pages = (entries + PAGE_ENTRIES - 1) / PAGE_ENTRIES;
+  unsigned int directory = 16; // grows as SnapshotIndex::add does
+  while (directory < pages)
+    directory *= 2;
+
+  return sizeof(Snapshot) + directory * sizeof(Page*) + pages * sizeof(Page)
+    + entries * sizeof(Voca);
+}
+
+Voca* Snapshot::get(unsigned int slot) const
+{
+  if (slot >= size)
+    return NULL;
+
+  return page[slot / PAGE_ENTRIES]->entry[slot % PAGE_ENTRIES];
+}
+
+int Snapshot::find(char* word) const
+{
+  for (unsigned int p = 0; p < pages; p++) {
+    for (unsigned int k = 0; k < page[p]->count; k++) {
+      if (!page[p]->entry[k]->isDead() &&
+          Strequal(page[p]->entry[k]->getWord(), word))
+        return p * PAGE_ENTRIES + k;
+    }
+  }
+
+  return -1;
+}
+
+int Snapshot::select(Random* r, long now) const
+{
+  long minDue = LONG_MAX;
+  int first = -1;
+  unsigned long long total = 0;
+
+  for (unsigned int p = 0; p < pages; p++) {
+    if (page[p]->minSlot >= 0 && page[p]->minDue < minDue) {
+      minDue = page[p]->minDue;
+      first = p * PAGE_ENTRIES + page[p]->minSlot;
+    }
+    total += page[p]->total;
+  }
+
+  if (first >= 0 && minDue <= now)
+    return first; // overdue word has priority
+  if (total == 0)
+    return -1;
+
+  unsigned long long pick = r->below(total);
+  for (unsigned int p = 0; p < pages; p++) {
+    if (pick >= page[p]->total) {
+      pick -= page[p]->total;
+      continue;
+    }
+    for (unsigned int k = 0; k < page[p]->count; k++) {
+      if (pick < page[p]->weight[k])
+        return p * PAGE_ENTRIES + k;
+      pick -= page[p]->weight[k];
+    }
+  }
+
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief SnapshotIndex class functions implementation
+///
+
+SnapshotIndex::SnapshotIndex(void) : next(NULL)
+{
+  current = new Snapshot(NULL);
+}
+
+SnapshotIndex::~SnapshotIndex(void)
+{
+  // data only next version reaches, and data replaced since publish
+  Snapshot *last = next ? next : current;
+  for (unsigned int p = 0; p < last->pages; p++) {
+    for (unsigned int k = 0; k < last->page[p]->count; k++)
+      delete(last->page[p]->entry[k]);
+    delete(last->page[p]);
+  }
+  for (unsigned int k = 0; k < garbage.getSize(); k++)
+    garbageRelease.get(k)(garbage.get(k));
+
+  if (next)
+    delete(next);
+  delete(current);
+}
+
+Snapshot* SnapshotIndex::acquire(int &ticket)
+{
+  ticket = epoch.enter();
+  return current;
+}
+
+void SnapshotIndex::release(int ticket)
+{
+  epoch.exit(ticket);
+}
+
+unsigned int SnapshotIndex::getPending(void) const
+{
+  return epoch.getPending();
+}
+
+void SnapshotIndex::releaseEntry(void* ptr)
+{
+  delete((Voca*)ptr);
+}
+
+void SnapshotIndex::releasePage(void* ptr)
+{
+  delete((Snapshot::Page*)ptr);
+}
+
+void SnapshotIndex::releaseSnapshot(void* ptr)
+{
+  delete((Snapshot*)ptr);
+}
+
+Snapshot* SnapshotIndex::prepare(void)
+{
+  if (!next)
+    next = new Snapshot(current);
+
+  return next;
+}
+
+Snapshot::Page* SnapshotIndex::own(unsigned int p)
+{
+  Snapshot::Page *page = next->page[p];
+  if (page->version == next->version)
+    return page; // already private
+
+  Snapshot::Page *copy = new Snapshot::Page(*page);
+  copy->version = next->version;
+  next->page[p] = copy;
+  discard(page, releasePage);
+
+  return copy;
+}
+
+void SnapshotIndex::discard(void* ptr, Epoch::Release release)
+{
+  garbage.add(ptr);
+  garbageRelease.add(release);
+}
+
+bool SnapshotIndex::add(Voca* v, unsigned int weight)
+{
+  Snapshot *s = prepare();
+  unsigned int p = s->size / Snapshot::PAGE_ENTRIES;
+
+  if (p == s->pages) { // last page is full
+    if (s->pages == s->capacity) {
+      unsigned int newCap = (s->capacity == 0) ? 16 : s->capacity * 2;
+      Snapshot::Page **newDir = new Snapshot::Page*[newCap];
+      if (!newDir)
+        return false;
+      for (unsigned int k = 0; k < s->pages; k++)
+        newDir[k] = s->page[k];
+      delete[] s->page;
+      s->page = newDir;
+      s->capacity = newCap;
+    }
+
+    Snapshot::Page *page = new Snapshot::Page();
+    page->count = 0;
+    page->version = s->version;
+    s->page[s->pages++] = page;
+  }
+
+  Snapshot::Page *page = own(p);
+  page->entry[page->count] = new Voca(*v);
+  page->weight[page->count] = weight;
+  page->count++;
+  s->size++;
+  s->count(v, 1);
+  Snapshot::summarize(page);
+
+  return true;
+}
+
+void SnapshotIndex::set(unsigned int slot, Voca* v, unsigned int weight)
+{
+  Snapshot *s = prepare();
+  if (slot >= s->size)
+    return;
+
+  Snapshot::Page *page = own(slot / Snapshot::PAGE_ENTRIES);
+  unsigned int k = slot % Snapshot::PAGE_ENTRIES;
+
+  s->count(page->entry[k], -1);
+  discard(page->entry[k], releaseEntry);
+  page->entry[k] = new Voca(*v);
+  page->weight[k] = weight;
+  s->count(v, 1);
+  Snapshot::summarize(page);
+}
+
+void SnapshotIndex::kill(unsigned int slot)
+{
+  Snapshot *s = prepare();
+  if (slot >= s->size || s->get(slot)->isDead())
+    return;
+
+  Snapshot::Page *page = own(slot / Snapshot::PAGE_ENTRIES);
+  unsigned int k = slot % Snapshot::PAGE_ENTRIES;
+  Voca *v = page->entry[k];
+
+  // entries are shared with older versions, so dead one is a new copy
+  s->count(v, -1);
+  discard(v, releaseEntry);
+  page->entry[k] = new Voca(*v);
+  page->entry[k]->kill();
+  page->weight[k] = 0;
+  s->dead++;
+  Snapshot::summarize(page);
+}
+
+void SnapshotIndex::clear(void)
+{
+  Snapshot *s = prepare();
+
+  for (unsigned int p = 0; p < s->pages; p++) {
+    for (unsigned int k = 0; k < s->page[p]->count; k++)
+      discard(s->page[p]->entry[k], releaseEntry);
+    discard(s->page[p], releasePage);
+  }
+  s->pages = 0;
+  s->size = 0;
+  s->dead = 0;
+  for (int l = 0; l < DeckStats::LEVELS; l++)
+    s->stats.perLevel[l] = 0;
+  s->stats.expSum = 0;
+  s->stats.mastered = 0;
+  s->stats.backlog = 0;
+}
+
+void SnapshotIndex::setHorizon(long h)
+{
+  Snapshot *s = prepare();
+
+  s->stats.horizon = h;
+  s->stats.backlog = 0;
+  for (unsigned int p = 0; p < s->pages; p++) {
+    for (unsigned int k = 0; k < s->page[p]->count; k++) {
+      Voca *v = s->page[p]->entry[k];
+      if (!v->isDead() && v->getDue() < h)
+        s->stats.backlog++;
+    }
+  }
+}
+
+void SnapshotIndex::answer(bool correct)
+{
+  Snapshot *s = prepare();
+
+  s->stats.answered++;
+  if (correct)
+    s->stats.correct++;
+}
+
+void SnapshotIndex::publish(void)
+{
+  if (!next)
+    return;
+
+  Snapshot *old = current;
+  __sync_synchronize(); // next is complete before it is reachable
+  current = next;
+  next = NULL;
+
+  epoch.retire(old, releaseSnapshot);
+  for (unsigned int k = 0; k < garbage.getSize(); k++)
+    epoch.retire(garbage.get(k), garbageRelease.get(k));
+  garbage.clear();
+  garbageRelease.clear();
+
+  epoch.reclaim();
+}
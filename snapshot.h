@@ -0,0 +1,335 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file snapshot.h
+/// @brief Snapshot Header File
+/// @details Immutable versions of deck for readers which never block, @n
+///          published by copy-on-write and reclaimed by epochs.
+///
+/// @section purpose_section Purpose
+/// Reading deck from many threads while it is updated
+///
+
+#ifndef __SNAPSHOT__
+#define __SNAPSHOT__
+
+#include "array.h"
+#include "sampler.h"
+
+class Voca;
+
+/// @brief running aggregates of live entries, adjusted by every change
+struct DeckStats
+{
+  static const int LEVELS = 8;  ///< level slots, other levels are not counted
+  unsigned int perLevel[LEVELS]; ///< live entries per level
+  long long expSum;             ///< sum of exp of live entries
+  unsigned int mastered;        ///< live entries at top level with full exp
+  long horizon;                 ///< backlog counts entries due before it
+  unsigned int backlog;         ///< live entries due before horizon
+  unsigned long answered;       ///< answers scored since engine started
+  unsigned long correct;        ///< correct answers since engine started
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Epoch Based Reclamation Class
+/// @details Readers mark a slot with global epoch while they hold shared @n
+///          data. Writer retires replaced data with current epoch and frees @n
+///          it only after every reader which could see it has left. Reader @n
+///          slots are cache line sized, so readers never share a written line. @n
+///          retire and reclaim are called by one writer at a time.
+///
+
+class Epoch
+{
+public:
+  static const int MAX_READERS = 64;  ///< the number of concurrent readers
+  typedef void (*Release)(void*);     ///< function freeing retired data
+
+private:
+  /// @brief reader slot, 0 if unused
+  struct Slot
+  {
+    volatile unsigned long epoch;     ///< epoch when reader entered
+    char pad[64 - sizeof(unsigned long)]; ///< one slot per cache line
+  };
+
+  /// @brief retired data waiting for readers to leave
+  struct Retired
+  {
+    void *ptr;                  ///< retired data
+    Release release;            ///< function freeing data
+    unsigned long epoch;        ///< epoch when it was retired
+    Retired *next;              ///< next retired data
+  };
+
+  Slot slot[MAX_READERS];       ///< reader slots
+  volatile unsigned long global;  ///< current epoch, starting from 1
+  Retired *retired;             ///< retired data list
+  unsigned int pending;         ///< the number of retired data
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  Epoch(void);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details Freeing every retired data, so no reader may be left.
+  ~Epoch(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of retired data not yet freed
+  unsigned int getPending(void) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief entering read side, waiting if every slot is used
+  ///
+  /// @retval ticket which is passed to exit
+  int enter(void);
+
+  /// @brief leaving read side
+  ///
+  /// @param ticket ticket which enter returned
+  void exit(int ticket);
+
+  /// @brief retiring data which new readers cannot reach any more
+  ///
+  /// @param ptr retired data
+  /// @param release function freeing data
+  void retire(void* ptr, Release release);
+
+  /// @brief freeing retired data which no reader can hold
+  void reclaim(void);
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Deck Snapshot Class
+/// @details One published version of deck. Entries are kept in fixed size @n
+///          pages, so a new version copies only page directory and changed @n
+///          pages, and shares the others. Each page keeps sum of weights and @n
+///          earliest due time, so selection visits pages before entries. @n
+///          Nothing in a published snapshot changes.
+///
+
+class Snapshot
+{
+  friend class SnapshotIndex;
+
+public:
+  static const unsigned int PAGE_ENTRIES = 128;  ///< entries per page
+
+private:
+  /// @brief fixed size run of entries
+  struct Page
+  {
+    Voca *entry[PAGE_ENTRIES];  ///< entries (shared among versions)
+    unsigned int weight[PAGE_ENTRIES];  ///< selection weight of entries
+    unsigned int count;         ///< the number of used entries
+    unsigned long total;        ///< sum of weights
+    long minDue;                ///< earliest due time
+    int minSlot;                ///< entry having earliest due, -1 if none
+    unsigned long version;      ///< snapshot version which created page
+  };
+
+  Page **page;                  ///< page directory
+  unsigned int pages;           ///< the number of pages
+  unsigned int capacity;        ///< directory size
+  unsigned int size;            ///< the number of entries
+  unsigned int dead;            ///< the number of deleted entries in size
+  unsigned long version;        ///< version number
+  DeckStats stats;              ///< aggregates of this version
+
+  /// @brief constructor copying directory of previous version
+  ///
+  /// @param prev previous version, NULL for empty one
+  Snapshot(Snapshot* prev);
+
+  /// @brief default destructor, pages and entries are not freed
+  ~Snapshot(void);
+
+  /// @brief recomputing weight sum and earliest due of page
+  static void summarize(Page* p);
+
+  /// @brief adding entry to aggregates or taking it out, O(1)
+  ///
+  /// @param v entry, deleted one is not counted
+  /// @param sign 1 to add, -1 to take out
+  void count(Voca* v, int sign);
+
+public:
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting version number, increasing with every publish
+  unsigned long getVersion(void) const;
+
+  /// @brief getting the number of entries, deleted ones included
+  unsigned int getSize(void) const;
+
+  /// @brief getting the number of entries which are not deleted
+  unsigned int getLive(void) const;
+
+  /// @brief getting aggregates of live entries, kept without scanning
+  const DeckStats& getStats(void) const;
+
+  /// @brief getting bytes of one version holding entries
+  /// @details Directory, pages and entry objects, strings of entries are @n
+  ///          not counted. Pages shared with older versions are counted once.
+  ///
+  /// @param entries the number of entries
+  /// @retval allocated bytes
+  static unsigned long bytesOf(unsigned int entries);
+
+  /// @brief getting entry of slot
+  ///
+  /// @param slot entry slot, same as engine index
+  /// @retval entry, which may be deleted, NULL if slot is out of range
+  Voca* get(unsigned int slot) const;
+
+  /// @brief finding entry of exactly same word
+  ///
+  /// @param word target word
+  /// @retval slot, -1 if there is none
+  int find(char* word) const;
+
+  /// @brief selecting question as engine does
+  /// @details Overdue entry comes first, otherwise entry is drawn with @n
+  ///          probability in proportion to its weight.
+  ///
+  /// @param r random generator of calling thread
+  /// @param now current time
+  /// @retval slot, -1 if there is no entry to select
+  int select(Random* r, long now) const;
+  /// @}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Snapshot Index Class
+/// @details Engine side of snapshots, mirroring engine slots like Sampler. @n
+///          Writer changes a private next version, copying pages on first @n
+///          write, and publish makes it current in one pointer store. @n
+///          Replaced version, pages and entries are retired to Epoch. @n
+///          Writer methods are called by one thread at a time, while @n
+///          acquire and release may be called by any thread at any time.
+///
+
+class SnapshotIndex
+{
+private:
+  Snapshot * volatile current;  ///< published version
+  Snapshot *next;               ///< private version, NULL if unchanged
+  Epoch epoch;                  ///< reclamation of replaced data
+  Array <void*> garbage;        ///< data replaced since last publish
+  Array <Epoch::Release> garbageRelease;  ///< release of each garbage
+
+  /// @brief getting private version, creating it if needed
+  Snapshot* prepare(void);
+
+  /// @brief getting private copy of page in next version
+  ///
+  /// @param p page number
+  Snapshot::Page* own(unsigned int p);
+
+  /// @brief keeping replaced data until publish
+  void discard(void* ptr, Epoch::Release release);
+
+  /// @brief freeing entry
+  static void releaseEntry(void* ptr);
+
+  /// @brief freeing page
+  static void releasePage(void* ptr);
+
+  /// @brief freeing snapshot and its directory
+  static void releaseSnapshot(void* ptr);
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor, publishing empty version
+  SnapshotIndex(void);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  /// @details Freeing every version, so no reader may be left.
+  ~SnapshotIndex(void);
+  /// @}
+
+  /// @name read side attributes
+  /// @{
+
+  /// @brief getting current version, which stays valid until release
+  ///
+  /// @param ticket receiving ticket which is passed to release
+  /// @retval current snapshot
+  Snapshot* acquire(int &ticket);
+
+  /// @brief releasing snapshot which acquire returned
+  ///
+  /// @param ticket ticket which acquire gave
+  void release(int ticket);
+
+  /// @brief getting the number of retired data not yet freed
+  unsigned int getPending(void) const;
+  /// @}
+
+  /// @name write side attributes
+  /// @{
+
+  /// @brief appending copy of vocabulary as last slot
+  ///
+  /// @param v vocabulary
+  /// @param weight selection weight
+  /// @retval true if success, false if fail
+  bool add(Voca* v, unsigned int weight);
+
+  /// @brief replacing slot by copy of vocabulary
+  ///
+  /// @param slot target slot
+  /// @param v vocabulary
+  /// @param weight selection weight
+  void set(unsigned int slot, Voca* v, unsigned int weight);
+
+  /// @brief marking slot deleted without shifting, weight becomes 0
+  ///
+  /// @param slot target slot
+  void kill(unsigned int slot);
+
+  /// @brief removing every slot
+  /// @details Answer counts and backlog horizon are kept.
+  void clear(void);
+
+  /// @brief moving backlog horizon and recounting backlog in O(n)
+  ///
+  /// @param h new horizon
+  void setHorizon(long h);
+
+  /// @brief counting one scored answer
+  ///
+  /// @param correct true if answer was correct
+  void answer(bool correct);
+
+  /// @brief making every change visible to readers at once
+  void publish(void);
+  /// @}
+};
+
+#endif /* __SNAPSHOT__ */
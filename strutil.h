@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file strutil.h
+/// @brief String Utility Library
+/// @details Self-implemented string handling inline functions, shared by @n
+///          VocaEngine and its helper modules. This file is both header @n
+///          file and source file.
+///
+/// @section purpose_section Purpose
+/// Handling strings without string header library
+///
+
+#ifndef __STRUTIL__
+#define __STRUTIL__
+
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Self-implemented multi-handy inline functions
+/// @details In this program, there are many functions handling string @n
+///          but for not using string header library, most string handling @n
+///          functions are created based on how it works basically.
+///
+
+static inline bool isWhite(char c) {
+  return (c == '\n' || c == '\t' || c == ' ');
+}
+
+static inline int Strlen(char* str) {
+  if (str == NULL) {
+    cout << "STRING LENGTH NULL ERROR" << endl;
+    exit(1);
+  }
+  
+  int i;
+  for (i = 0; str[i] != '\0'; i++) {}
+  
+  return i;
+}
+
+static inline void Strcpy(char* dst, char* src) {
+  if (dst == NULL || src == NULL) {
+    cout << "STRING COPY NULL ERROR" << endl;
+    exit(1);
+  }
+
+  int i;
+  for (i = 0; src[i] != '\0'; i++)
+    dst[i] = src[i];
+  
+  dst[i] = '\0';
+}
+
+static inline char* Strjoin(char* str1, char* str2) {
+  char *ret = new char[sizeof(char) * (Strlen(str1) + Strlen(str2)) + 1];
+
+  Strcpy(ret, str1);
+  Strcpy(ret + Strlen(str1), str2);
+
+  return ret;
+}
+
+static inline bool Strequal(char* str1, char* str2) {
+  if (str1 == NULL || str2 == NULL) {
+    cout << "STRING NULL ERROR" << endl;
+    exit(1);
+  }
+
+  int i;
+  for (i = 0; str1[i] != '\0'; i++) {
+    if (str1[i] != str2[i])
+      return false;
+  }
+
+  return str2[i] == '\0';
+}
+
+static inline int Strcmp(char* str1, char* str2) {
+  if (str1 == NULL || str2 == NULL) {
+    cout << "STRING NULL ERROR" << endl;
+    exit(1);
+  }
+
+  // byte order, which is also code point order of UTF-8
+  int i;
+  for (i = 0; str1[i] != '\0' && str1[i] == str2[i]; i++) {}
+
+  return (int)(unsigned char)str1[i] - (int)(unsigned char)str2[i];
+}
+
+static inline int Strtype(char* str) { // 0 : null, 1 : ascii, 2: unicode
+  if (str) {
+    if ((int)str[0] >= 0) // including ascii NULL
+      return 1; // ascii
+    else
+      return 2; // unicode
+  }
+
+  return 0; // null
+}
+
+static inline char Strlower(char c) {
+  return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static inline char* Strtrim(char* str, bool fold = false) {
+  // surrounding white space trimmed, fold : ascii case is folded too
+  int first = 0, last = Strlen(str);
+  while (first < last && isWhite(str[first]))
+    first++;
+  while (last > first && isWhite(str[last - 1]))
+    last--;
+
+  char *ret = new char[sizeof(char) * (last - first) + 1];
+  for (int i = first; i < last; i++)
+    ret[i - first] = fold ? Strlower(str[i]) : str[i];
+  ret[last - first] = '\0';
+
+  return ret;
+}
+
+static inline int Strsim(char* str1, char* str2, int type) { // type [ 1: ascii, 2: unicode ]
+  char *larger = NULL; char *smaller = NULL;
+  int len1 = Strlen(str1), len2 = Strlen(str2);
+  int largeLen, smallLen;
+  
+  if (len1 >= len2) {
+    larger = str1; smaller = str2;
+    largeLen = len1; smallLen = len2;
+  } else {
+    larger = str2; smaller = str1;
+    largeLen = len2; smallLen = len1;
+  }
+
+  // longest common substring over half of smaller one, by character unit
+  int step = (type == 1) ? 1 : 3; // ascii : 1 byte, unicode : 3 bytes
+  
+  for (int tmpSize = smallLen; tmpSize > (smallLen / 2); tmpSize -= step) {
+    for (int tmpIndex = 0; tmpIndex <= (smallLen - tmpSize); tmpIndex += step) {
+      for (int cmpIndex = 0; cmpIndex <= (largeLen - tmpSize); cmpIndex += step) {
+        bool equal = true;
+        for (int i = 0; i < tmpSize; i++) {
+          if (smaller[tmpIndex + i] != larger[cmpIndex + i]) {
+            equal = false;
+            break;
+          }
+        }
+
+        if (equal)
+          return 100 * tmpSize / largeLen;
+      }
+    }
+  }
+
+  return 0; // no match
+}
+
+static inline unsigned long long Strhash(char* str, unsigned long long hash) {
+  // FNV-1a, chaining from given hash
+  for (int i = 0; str[i] != '\0'; i++) {
+    hash ^= (unsigned char)str[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+static inline long StrToInt(char* str) {
+  long ret = 0;
+
+  for (int i = 0; i < Strlen(str); i++)
+    ret = (ret * 10) + (int)(str[i] - '0');
+
+  return ret;
+}
+
+static inline char* IntToStr(long num) {
+  long tmp = num;
+  int length = 0;
+  
+  if (num == 0) {
+    char *ret = new char[2];
+    ret[0] = '0'; ret[1] = '\0';
+    return ret;
+  }
+
+  while (tmp > 0) {
+    tmp /= 10;
+    length++;
+  }
+
+  char *buf = new char[sizeof(char) * length + 1];
+  
+  int index = length - 1;
+  for (tmp = num; tmp > 0; tmp /= 10)
+    buf[index--] = (char)(tmp % 10 + '0');
+  buf[length] = '\0';
+
+  return buf;
+}
+
+#endif /* __STRUTIL__ */
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file wordhash.cpp
+/// @brief Word Hash Table Source File
+/// @details Open addressing hash table from word string to integer value
+///
+/// @section purpose_section Purpose
+/// Exact word lookup without scanning whole list
+///
+
+#include "wordhash.h"
+#include "strutil.h"
+
+#define FNV_OFFSET    14695981039346656037ULL
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief WordHash class functions implementation
+///
+
+WordHash::WordHash(void) : key(NULL), value(NULL), hash(NULL), size(0),
+  capacity(0)
+{
+}
+
+WordHash::~WordHash(void)
+{
+  if (key)
+    delete[] key;
+  if (value)
+    delete[] value;
+  if (hash)
+    delete[] hash;
+}
+
+bool WordHash::grow(unsigned int need)
+{
+  if (need * 2 <= capacity)
+    return true;
+
+  unsigned int newCap = (capacity == 0) ? 64 : capacity;
+  while (newCap < need * 2)
+    newCap *= 2;
+
+  char **oldKey = key;
+  int *oldValue = value;
+  unsigned long long *oldHash = hash;
+  unsigned int oldCap = capacity;
+
+  key = new char*[newCap];
+  value = new int[newCap];
+  hash = new unsigned long long[newCap];
+  if (!key || !value || !hash)
+    return false;
+  capacity = newCap;
+
+  for (unsigned int b = 0; b < capacity; b++)
+    key[b] = NULL;
+
+  // rehash with cached hash, no string is read again
+  for (unsigned int b = 0; b < oldCap; b++) {
+    if (!oldKey[b])
+      continue;
+
+    unsigned int p = (unsigned int)oldHash[b] & (capacity - 1);
+    while (key[p])
+      p = (p + 1) & (capacity - 1);
+    key[p] = oldKey[b];
+    value[p] = oldValue[b];
+    hash[p] = oldHash[b];
+  }
+
+  if (oldKey)
+    delete[] oldKey;
+  if (oldValue)
+    delete[] oldValue;
+  if (oldHash)
+    delete[] oldHash;
+  return true;
+}
+
+unsigned int WordHash::probe(char* word, unsigned long long h) const
+{
+  unsigned int p = (unsigned int)h & (capacity - 1);
+
+  while (key[p] && (hash[p] != h || !Strequal(key[p], word)))
+    p = (p + 1) & (capacity - 1);
+
+  return p;
+}
+
+unsigned int WordHash::getSize(void) const
+{
+  return size;
+}
+
+int WordHash::find(char* word) const
+{
+  if (size == 0)
+    return -1;
+
+  unsigned int p = probe(word, Strhash(word, FNV_OFFSET));
+  if (!key[p])
+    return -1;
+
+  return value[p];
+}
+
+bool WordHash::insert(char* word, int v)
+{
+  if (!grow(size + 1))
+    return false;
+
+  unsigned long long h = Strhash(word, FNV_OFFSET);
+  unsigned int p = probe(word, h);
+
+  if (!key[p]) {
+    key[p] = word;
+    hash[p] = h;
+    size++;
+  }
+  value[p] = v;
+
+  return true;
+}
+
+void WordHash::clear(void)
+{
+  for (unsigned int b = 0; b < capacity; b++)
+    key[b] = NULL;
+  size = 0;
+}
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @file wordhash.h
+/// @brief Word Hash Table Header File
+/// @details Open addressing hash table from word string to integer value
+///
+/// @section purpose_section Purpose
+/// Exact word lookup without scanning whole list
+///
+
+#ifndef __WORDHASH__
+#define __WORDHASH__
+
+////////////////////////////////////////////////////////////////////////////////
+///
+/// @brief Word Hash Table Class
+/// @details Linear probing table keyed by FNV-1a hash of word. Keys are @n
+///          not copied, so every key string should outlive the table or be @n
+///          removed by clear. Table keeps load factor under one half, so @n
+///          lookup and insert are O(1) on average.
+///
+
+class WordHash
+{
+private:
+  char **key;                 ///< key strings (not owned), NULL if empty
+  int *value;                 ///< value of each key
+  unsigned long long *hash;   ///< cached hash of each key
+  unsigned int size;          ///< the number of keys
+  unsigned int capacity;      ///< the number of buckets, power of two
+
+  /// @brief growing buckets to keep load factor
+  ///
+  /// @param need the number of keys which should fit
+  /// @retval true if success, false if fail
+  bool grow(unsigned int need);
+
+  /// @brief finding bucket of word
+  ///
+  /// @param word target word
+  /// @param h hash of target word
+  /// @retval bucket index, which is empty if word is absent
+  unsigned int probe(char* word, unsigned long long h) const;
+
+public:
+  /// @name constructors
+  /// @{
+
+  /// @brief default constructor
+  WordHash(void);
+  /// @}
+
+  /// @name destructors
+  /// @{
+
+  /// @brief default destructor
+  ~WordHash(void);
+  /// @}
+
+  /// @name informative attributes
+  /// @{
+
+  /// @brief getting the number of keys
+  ///
+  /// @retval the number of keys
+  unsigned int getSize(void) const;
+
+  /// @brief finding value of word
+  ///
+  /// @param word target word
+  /// @retval value, -1 if word is absent
+  int find(char* word) const;
+  /// @}
+
+  /// @name functional attributes
+  /// @{
+
+  /// @brief inserting word, or replacing its value if it exists
+  ///
+  /// @param word key string, which is not copied
+  /// @param v value
+  /// @retval true if success, false if fail
+  bool insert(char* word, int v);
+
+  /// @brief removing every key
+  void clear(void);
+  /// @}
+};
+
+#endif /* __WORDHASH__ */